@@ -1,9 +1,15 @@
 #include <stdio.h>
 #include <set>
+#include <map>
+#include <optional>
+#include <vector>
+#include <chrono>
+#include <thread>
 
 #include <TrivialTestKit.h>
 #include <ToStr.h>
 
+#define LOGGER_USE_SOCKET
 #include <Logger.h>
 
 //------------------------------------------------------------------------------
@@ -420,6 +426,1772 @@ void TestLoggerLog() {
     }
 }
 
+void TestLoggerSanitizeUTF8() {
+    // validation
+    {
+        TTK_ASSERT(Logger::IsValidUTF8(""));
+        TTK_ASSERT(Logger::IsValidUTF8("Some ascii text which is longer than sixteen bytes."));
+        TTK_ASSERT(Logger::IsValidUTF8(u8"Some text \u0444 \u20AC \U0001F600."));
+        TTK_ASSERT(!Logger::IsValidUTF8("Some text \xFF."));
+        TTK_ASSERT(!Logger::IsValidUTF8("Some text \xC0\xAF."));         // overlong
+        TTK_ASSERT(!Logger::IsValidUTF8("Some text \xED\xA0\x80."));     // surrogate
+        TTK_ASSERT(!Logger::IsValidUTF8("Some text \xF4\x90\x80\x80.")); // above U+10FFFF
+        TTK_ASSERT(!Logger::IsValidUTF8("Some text \xE2\x82"));         // truncated
+
+        TTK_ASSERT(Logger::FindInvalidUTF8("0123456789abcdefghij\xFF", 21) == 20);
+    }
+
+    // sanitization
+    {
+        std::string text = "Some \xFF text \xE2\x82 with \xC0\xAF invalid \u0444 sequences.";
+        Logger::SanitizeUTF8(text);
+        TTK_ASSERT_M(text == u8"Some \uFFFD text \uFFFD with \uFFFD\uFFFD invalid \u0444 sequences.", text);
+
+        text = u8"Valid text \u0444.";
+        Logger::SanitizeUTF8(text);
+        TTK_ASSERT(text == u8"Valid text \u0444.");
+    }
+
+    // log
+    {
+        const std::string file_name = "log\\test\\TestLoggerSanitizeUTF8.txt";
+        DeleteFileA(file_name.c_str());
+
+        Logger logger;
+        logger.OpenFile(file_name, false);
+
+        logger.LogDump("Dump \xFF.");
+        logger.Enable(LoggerOption::SANITIZE_UTF8);
+        logger.LogDump("Dump \xFF.");
+        logger.LogEvent("%s %d.", "Event \xE2\x82", 1);
+
+        logger.CloseFile();
+
+        const std::string expected_text = std::string("[Dump]: Dump \xFF.\n") +
+            u8"[Dump]: Dump \uFFFD.\n"
+            u8"[Event]: Event \uFFFD 1.\n";
+
+        TTK_ASSERT(IsFileExists(file_name));
+        TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+    }
+}
+
+void TestLoggerFileBatch() {
+    const std::string file_name = "log\\test\\TestLoggerFileBatch.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    TTK_ASSERT(logger.GetFileBatchSize() == 0);
+
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64);
+    TTK_ASSERT(logger.GetFileBatchSize() == 64);
+
+    logger.LogDump("Dump.");
+    logger.LogEvent("Event.");
+    TTK_ASSERT(LoadTextFromFile(file_name) == "");
+
+    logger.LogWarning("Some longer warning which fills up batch.");
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == "[Dump]: Dump.\n[Event]: Event.\n[Warning]: Some longer warning which fills up batch.\n", LoadTextFromFile(file_name));
+
+    logger.LogDump("Dump.");
+    logger.Flush();
+    TTK_ASSERT(LoadTextFromFile(file_name) == "[Dump]: Dump.\n[Event]: Event.\n[Warning]: Some longer warning which fills up batch.\n[Dump]: Dump.\n");
+
+    logger.LogDump("Dump.");
+    logger.LogError("Error.");
+    TTK_ASSERT(LoadTextFromFile(file_name) == "[Dump]: Dump.\n[Event]: Event.\n[Warning]: Some longer warning which fills up batch.\n[Dump]: Dump.\n[Dump]: Dump.\n[Error]: Error.\n");
+
+    logger.LogEvent("Event.");
+    logger.CloseFile();
+    TTK_ASSERT(LoadTextFromFile(file_name) == "[Dump]: Dump.\n[Event]: Event.\n[Warning]: Some longer warning which fills up batch.\n[Dump]: Dump.\n[Dump]: Dump.\n[Error]: Error.\n[Event]: Event.\n");
+}
+
+void TestLoggerRegistry() {
+    const std::string file_name = "log\\test\\TestLoggerRegistry.txt";
+    DeleteFileA(file_name.c_str());
+
+    LoggerRegistry registry;
+
+    Logger& root = registry.GetRoot();
+    TTK_ASSERT(&registry.Get("") == &root);
+    TTK_ASSERT(root.GetName() == "");
+
+    root.OpenFile(file_name, false);
+
+    Logger& net = registry.Get("net");
+    TTK_ASSERT(&registry.Get("net") == &net);
+    TTK_ASSERT(net.GetName() == "net");
+    TTK_ASSERT(net.IsFileOpened());
+
+    net.Disable(LoggerOption::LOG_DUMP);
+
+    Logger& http = registry.Get("net.http");
+    TTK_ASSERT(&registry.Get("net.http") == &http);
+    TTK_ASSERT(&registry.Get("net") == &net);
+
+    Logger& gui = registry.Get("gui");
+
+    root.LogDump("Dump.");
+    net.LogDump("Dump.");
+    http.LogDump("Dump.");
+    gui.LogDump("Dump.");
+    http.LogEvent("Event %d.", 1);
+    LOGGER_TRACE(net, "Trace.");
+
+    // Output functions of logger from registry act on root logger.
+    gui.CloseFile();
+    TTK_ASSERT(!root.IsFileOpened());
+
+    gui.OpenFile(file_name, true);
+    TTK_ASSERT(root.IsFileOpened());
+    gui.LogEvent("Reopened.");
+
+    root.CloseFile();
+
+    const std::string expected_text =
+        "[Dump]: Dump.\n"
+        "[gui][Dump]: Dump.\n"
+        "[net.http][Event]: Event 1.\n"
+        "[net][Trace][TestLoggerRegistry]: Trace.\n"
+        "[gui][Event]: Reopened.\n";
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+
+    // Lookup while other threads create loggers.
+    {
+        enum { THREAD_COUNT = 4, NAME_COUNT = 64 };
+
+        LoggerRegistry concurrent_registry;
+        Logger* loggers[THREAD_COUNT][NAME_COUNT] = {};
+
+        std::vector<std::thread> threads;
+        for (int thread_index = 0; thread_index < THREAD_COUNT; ++thread_index) {
+            threads.push_back(std::thread([&concurrent_registry, &loggers, thread_index]() {
+                for (int index = 0; index < NAME_COUNT; ++index) {
+                    loggers[thread_index][index] = &concurrent_registry.Get("worker." + std::to_string(index));
+                }
+            }));
+        }
+        for (std::thread& thread : threads) thread.join();
+
+        for (int index = 0; index < NAME_COUNT; ++index) {
+            Logger& logger = concurrent_registry.Get("worker." + std::to_string(index));
+            TTK_ASSERT(logger.GetName() == "worker." + std::to_string(index));
+            for (int thread_index = 0; thread_index < THREAD_COUNT; ++thread_index) TTK_ASSERT(loggers[thread_index][index] == &logger);
+        }
+    }
+}
+
+void TestLoggerStats() {
+    const std::string file_name = "log\\test\\TestLoggerStats.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    logger.LogDump("Not counted.");
+
+    logger.Enable(LoggerOption::COLLECT_STATS);
+
+    logger.LogText("Text.\n");
+    logger.LogDump("Dump.");
+    logger.LogDump("Dump.");
+    logger.LogEvent("Event %d.", 1);
+    logger.LogError("Error.");
+    logger.Disable(LoggerOption::LOG_WARNING);
+    logger.LogWarning("Warning.");
+
+    LoggerStats stats = logger.GetStats();
+    TTK_ASSERT(stats.text.entry_count == 1);
+    TTK_ASSERT(stats.text.byte_count == strlen("Text.\n"));
+    TTK_ASSERT(stats.dump.entry_count == 2);
+    TTK_ASSERT(stats.dump.byte_count == 2 * strlen("[Dump]: Dump.\n"));
+    TTK_ASSERT(stats.event.entry_count == 1);
+    TTK_ASSERT(stats.event.byte_count == strlen("[Event]: Event 1.\n"));
+    TTK_ASSERT(stats.warning.entry_count == 0);
+    TTK_ASSERT(stats.error.entry_count == 1);
+    TTK_ASSERT(stats.suppressed_count == 1);
+    TTK_ASSERT(stats.dropped_count == 0);
+    TTK_ASSERT(stats.flush_count == 5);
+
+    logger.ResetStats();
+    stats = logger.GetStats();
+    TTK_ASSERT(stats.dump.entry_count == 0);
+    TTK_ASSERT(stats.flush_count == 0);
+
+    // periodic summary
+    logger.SetStatsInterval(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    logger.LogEvent("Event.");
+
+    logger.CloseFile();
+
+    const std::string text = LoadTextFromFile(file_name);
+    TTK_ASSERT_M(text.find("[Event]: Event.\n[Stats]: entries: 1, bytes: 16, suppressed: 0, dropped: 0, flushes: 1, ") != std::string::npos, text);
+}
+
+void TestLoggerHexDump() {
+    const std::string file_name = "log\\test\\TestLoggerHexDump.txt";
+    DeleteFileA(file_name.c_str());
+
+    unsigned char data[40];
+    for (size_t index = 0; index < sizeof(data); ++index) data[index] = (unsigned char)(0x30 + index);
+
+    Logger logger;
+    TTK_ASSERT(logger.GetHexDumpLimit() == 65536);
+
+    logger.OpenFile(file_name, false);
+
+    logger.LogHexDump("Hello World\n\0\1\2\3", 16, "Frame %d:", 1);
+    logger.LogHexDump(data, sizeof(data), "Frame %d:", 2);
+    logger.LogHexDump(data, 0, "Empty.");
+
+    logger.SetHexDumpLimit(20);
+    logger.LogHexDump(data, sizeof(data), "Truncated.");
+
+    logger.Disable(LoggerOption::LOG_DUMP);
+    logger.LogHexDump(data, sizeof(data), "Disabled.");
+
+    logger.CloseFile();
+
+    const std::string expected_text =
+        "[Dump]: Frame 1:\n"
+        "00000000  48 65 6C 6C 6F 20 57 6F  72 6C 64 0A 00 01 02 03  |Hello World.....|\n"
+        "[Dump]: Frame 2:\n"
+        "00000000  30 31 32 33 34 35 36 37  38 39 3A 3B 3C 3D 3E 3F  |0123456789:;<=>?|\n"
+        "00000010  40 41 42 43 44 45 46 47  48 49 4A 4B 4C 4D 4E 4F  |@ABCDEFGHIJKLMNO|\n"
+        "00000020  50 51 52 53 54 55 56 57                           |PQRSTUVW|\n"
+        "[Dump]: Empty.\n"
+        "[Dump]: Truncated.\n"
+        "00000000  30 31 32 33 34 35 36 37  38 39 3A 3B 3C 3D 3E 3F  |0123456789:;<=>?|\n"
+        "00000010  40 41 42 43                                       |@ABC|\n"
+        "(20 more bytes not dumped)\n";
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+}
+
+void TestLoggerCompressedFile() {
+    const std::string file_name         = "log\\test\\TestLoggerCompressedFile.lgz";
+    const std::string output_file_name  = "log\\test\\TestLoggerCompressedFile.txt";
+    DeleteFileA(file_name.c_str());
+    DeleteFileA(output_file_name.c_str());
+
+    std::string expected_text;
+
+    {
+        Logger logger;
+        logger.OpenCompressedFile(file_name, false, LoggerCompression::LZ, 1024);
+        TTK_ASSERT(logger.IsFileOpened());
+        TTK_ASSERT(logger.IsCompressedFileOpened());
+
+        for (int index = 0; index < 1000; ++index) {
+            logger.LogEvent("Some event message %d.", index);
+            expected_text += "[Event]: Some event message " + std::to_string(index) + ".\n";
+        }
+        logger.LogError("Error.");
+        expected_text += "[Error]: Error.\n";
+
+        // All blocks are written after logging error, before file is closed.
+        TTK_ASSERT(LoggerCompressedFileReader::DecompressFile(file_name, output_file_name));
+        TTK_ASSERT(LoadTextFromFile(output_file_name) == expected_text);
+
+        logger.CloseFile();
+        TTK_ASSERT(!logger.IsCompressedFileOpened());
+    }
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT(LoadTextFromFile(file_name).length() < expected_text.length() / 2);
+
+    LoggerCompressedFileReader reader;
+    TTK_ASSERT(reader.Open(file_name));
+    TTK_ASSERT(reader.IsOpened());
+    TTK_ASSERT(reader.GetBlockCount() > 1);
+
+    std::string text;
+    TTK_ASSERT(reader.ReadAll(text));
+    TTK_ASSERT(text == expected_text);
+
+    // seek to block
+    const size_t index = reader.GetBlockCount() / 2;
+    TTK_ASSERT(reader.ReadBlock(index, text));
+    TTK_ASSERT(text == expected_text.substr(size_t(reader.GetBlockTextOffset(index)), text.length()));
+    TTK_ASSERT(!reader.ReadBlock(reader.GetBlockCount(), text));
+
+    reader.Close();
+    TTK_ASSERT(!reader.IsOpened());
+
+    TTK_ASSERT(LoggerCompressedFileReader::DecompressFile(file_name, output_file_name));
+    TTK_ASSERT(LoadTextFromFile(output_file_name) == expected_text);
+
+    // not compressed log file
+    TTK_ASSERT(!reader.Open(output_file_name));
+}
+
+void TestLoggerSharedMemory() {
+    const std::string file_name = "log\\test\\TestLoggerSharedMemory.txt";
+    DeleteFileA(file_name.c_str());
+
+    LoggerCollector collector;
+    TTK_ASSERT(collector.Create("LoggerTest_SharedMemory", 8, 64));
+    TTK_ASSERT(!LoggerCollector().Create("LoggerTest_SharedMemory", 8, 64));
+
+    Logger output;
+    output.OpenFile(file_name, false);
+
+    Logger logger;
+    TTK_ASSERT(!logger.IsSharedMemoryOpened());
+    logger.OpenSharedMemory("LoggerTest_SharedMemory");
+    TTK_ASSERT(logger.IsSharedMemoryOpened());
+    logger.Enable(LoggerOption::COLLECT_STATS);
+
+    const std::string long_text(150, 'x');
+
+    logger.LogDump("Dump.");
+    logger.LogEvent("Event %s.", long_text.c_str());
+    TTK_ASSERT(collector.Collect(output) == 2);
+
+    // full ring
+    for (int index = 0; index < 10; ++index) logger.LogWarning("Warning %d.", index);
+    TTK_ASSERT(collector.GetDroppedCount() == 2);
+    TTK_ASSERT(logger.GetStats().dropped_count == 2);
+    TTK_ASSERT(collector.Collect(output) == 8);
+    TTK_ASSERT(collector.Collect(output) == 0);
+
+    // background collecting
+    collector.Start(output, 1);
+    logger.LogError("Error.");
+    collector.Stop();
+
+    logger.CloseSharedMemory();
+    TTK_ASSERT(!logger.IsSharedMemoryOpened());
+    output.CloseFile();
+
+    std::string expected_text = "[Dump]: Dump.\n[Event]: Event " + long_text + ".\n";
+    for (int index = 0; index < 8; ++index) expected_text += "[Warning]: Warning " + std::to_string(index) + ".\n";
+    expected_text += "[Error]: Error.\n";
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+    TTK_ASSERT(collector.GetAbandonedCount() == 0);
+
+    // Writer delayed until its slot is abandoned and reused by next lap of ring.
+    {
+        LoggerSharedRing reader;
+        TTK_ASSERT(reader.Create("LoggerTest_SharedMemoryStale", 4, 64));
+
+        LoggerSharedRing writer;
+        TTK_ASSERT(writer.Open("LoggerTest_SharedMemoryStale"));
+
+        uint64_t stale_position = 0;
+        TTK_ASSERT(writer.Reserve(5, stale_position));
+
+        std::string text;
+        TTK_ASSERT(!reader.Pop(text, 0));
+        TTK_ASSERT(!reader.Pop(text, 0));
+        TTK_ASSERT(reader.GetAbandonedCount() == 1);
+
+        for (int index = 0; index < 4; ++index) TTK_ASSERT(writer.Push(("Next " + std::to_string(index)).c_str(), 6));
+
+        TTK_ASSERT(!writer.Commit(stale_position, "Stale", 5));
+        TTK_ASSERT(reader.GetDroppedCount() == 1);
+
+        for (int index = 0; index < 4; ++index) {
+            TTK_ASSERT(reader.Pop(text, 0));
+            TTK_ASSERT_M(text == "Next " + std::to_string(index), text);
+        }
+        TTK_ASSERT(!reader.Pop(text, 0));
+        TTK_ASSERT(reader.GetAbandonedCount() == 1);
+    }
+}
+
+void TestLoggerShardedFiles() {
+    const std::string file_name_prefix  = "log\\test\\TestLoggerShardedFiles";
+    const std::string file_name         = "log\\test\\TestLoggerShardedFiles.txt";
+    DeleteFileA(file_name.c_str());
+
+    enum { THREAD_COUNT = 4, ENTRY_COUNT = 1000 };
+
+    Logger logger;
+    TTK_ASSERT(!logger.IsShardedFilesOpened());
+    logger.OpenShardedFiles(file_name_prefix);
+    TTK_ASSERT(logger.IsShardedFilesOpened());
+
+    logger.LogEvent("Main thread.");
+
+    std::vector<std::thread> threads;
+    for (int thread_index = 0; thread_index < THREAD_COUNT; ++thread_index) {
+        threads.push_back(std::thread([&logger, thread_index]() {
+            Logger::SetThreadName("Worker " + std::to_string(thread_index));
+            for (int index = 0; index < ENTRY_COUNT; ++index) logger.LogEvent("%d %d", thread_index, index);
+        }));
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    const std::vector<std::string> shard_file_names = logger.GetShardFileNames();
+    TTK_ASSERT(shard_file_names.size() == THREAD_COUNT + 1);
+
+    logger.CloseFile();
+    TTK_ASSERT(!logger.IsShardedFilesOpened());
+
+    TTK_ASSERT(Logger::MergeShardFiles(shard_file_names, file_name, false));
+
+    // Entries of each thread must keep their order.
+    const std::string text = LoadTextFromFile(file_name);
+    TTK_ASSERT(text.find("[Event]: Main thread.\n") == 0);
+
+    int next_indexes[THREAD_COUNT] = {};
+    size_t line_count = 0;
+    for (size_t begin = 0; begin < text.length();) {
+        const size_t end = text.find('\n', begin);
+        if (end == std::string::npos) break;
+
+        const std::string line = text.substr(begin, end - begin);
+        const size_t separator = line.find(' ', strlen("[Event]: "));
+
+        if (line != "[Event]: Main thread." && separator != std::string::npos) {
+            const int thread_index  = atoi(line.c_str() + strlen("[Event]: "));
+            const int index         = atoi(line.c_str() + separator + 1);
+
+            TTK_ASSERT(thread_index >= 0 && thread_index < THREAD_COUNT && next_indexes[thread_index] == index);
+            if (thread_index >= 0 && thread_index < THREAD_COUNT) next_indexes[thread_index] = index + 1;
+        }
+        ++line_count;
+        begin = end + 1;
+    }
+    TTK_ASSERT(line_count == THREAD_COUNT * ENTRY_COUNT + 1);
+
+    TTK_ASSERT(Logger::MergeShardFiles(shard_file_names, file_name, true));
+    TTK_ASSERT(LoadTextFromFile(file_name).find("][Worker_0][Event]: 0 0\n") != std::string::npos);
+
+    TTK_ASSERT(!Logger::MergeShardFiles({"log\\test\\NotExistingShard.shard"}, file_name, false));
+
+    // Two sharded loggers used alternately by the same thread.
+    Logger logger_a;
+    Logger logger_b;
+    logger_a.OpenShardedFiles(file_name_prefix + "A");
+    logger_b.OpenShardedFiles(file_name_prefix + "B");
+
+    logger_a.LogEvent("A first.");
+    logger_b.LogEvent("B first.");
+    logger_a.LogEvent("A second.");
+
+    const std::vector<std::string> shard_file_names_a = logger_a.GetShardFileNames();
+    TTK_ASSERT(shard_file_names_a.size() == 1);
+
+    logger_a.CloseFile();
+    logger_b.CloseFile();
+
+    TTK_ASSERT(Logger::MergeShardFiles(shard_file_names_a, file_name, false));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == "[Event]: A first.\n[Event]: A second.\n", LoadTextFromFile(file_name));
+}
+
+LOGGER_CATEGORY(Audit, "Audit", 350);
+LOGGER_CATEGORY(Metric, "Metric", 50);
+
+void TestLoggerCategories() {
+    const std::string file_name = "log\\test\\TestLoggerCategories.txt";
+    DeleteFileA(file_name.c_str());
+
+    static_assert(LoggerCategoryPrefix<Audit>::LENGTH == 9, "");
+    TTK_ASSERT(std::string(LoggerCategoryPrefix<Audit>::TEXT.data()) == "[Audit]: ");
+    TTK_ASSERT(std::string(LoggerCategoryPrefix<LoggerCategory::FatalError>::TEXT.data()) == "[Fatal Error]: ");
+
+    Logger logger;
+    TTK_ASSERT(logger.GetMinSeverity() == 0);
+    TTK_ASSERT(logger.IsEnabled<Audit>());
+    TTK_ASSERT(logger.IsEnabled<Metric>());
+
+    logger.OpenFile(file_name, false);
+    logger.Enable(LoggerOption::COLLECT_STATS);
+
+    logger.Log<Audit>("User %s logged in.", "admin");
+    logger.Log<Metric>("fps=%d", 60);
+    logger.Log<LoggerCategory::Event>("Some event.");
+
+    logger.Disable<Metric>();
+    TTK_ASSERT(!logger.IsEnabled<Metric>());
+    TTK_ASSERT(logger.IsEnabled<Audit>());
+    logger.Log<Metric>("fps=%d", 30);
+    logger.Enable<Metric>();
+    logger.Log<Metric>("fps=%d", 20);
+
+    logger.Disable<LoggerCategory::Dump>();
+    TTK_ASSERT(!logger.IsEnabled<LoggerCategory::Dump>());
+    logger.LogDump("Not logged.");
+    logger.Enable(LoggerOption::LOG_DUMP);
+    TTK_ASSERT(logger.IsEnabled<LoggerCategory::Dump>());
+
+    logger.SetMinSeverity(LoggerCategory::Warning::SEVERITY);
+    TTK_ASSERT(!logger.IsEnabled<Metric>());
+    TTK_ASSERT(!logger.IsEnabled<LoggerCategory::Event>());
+    logger.Log<Metric>("fps=%d", 10);
+    logger.LogEvent("Not logged.");
+    logger.LogDump("Not logged.");
+    logger.Log<Audit>("User %s logged out.", "admin");
+    logger.LogWarning("Some warning.");
+
+    logger.SetMinSeverity(1000);
+    logger.LogWarning("Not logged.");
+    logger.LogError("Some error.");
+
+    const LoggerStats stats = logger.GetStats();
+    TTK_ASSERT(stats.custom.entry_count == 4);
+    TTK_ASSERT(stats.event.entry_count == 1);
+    TTK_ASSERT(stats.error.entry_count == 1);
+    TTK_ASSERT(stats.suppressed_count == 6);
+
+    logger.CloseFile();
+
+    const std::string expected_text =
+        "[Audit]: User admin logged in.\n"
+        "[Metric]: fps=60\n"
+        "[Event]: Some event.\n"
+        "[Metric]: fps=20\n"
+        "[Audit]: User admin logged out.\n"
+        "[Warning]: Some warning.\n"
+        "[Error]: Some error.\n";
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+}
+
+void TestLoggerContext() {
+    const std::string file_name = "log\\test\\TestLoggerContext.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    TTK_ASSERT(Logger::GetContext() == "");
+    logger.LogEvent("No context.");
+    {
+        Logger::Context request_context("request", "42");
+        TTK_ASSERT(Logger::GetContext() == "[request=42]");
+        logger.LogEvent("Some event %d.", 1);
+        {
+            Logger::Context session_context("session", "7");
+            TTK_ASSERT(Logger::GetContext() == "[request=42][session=7]");
+            logger.LogWarning("Some warning.");
+            logger.LogTrace("Foo", "Some trace.");
+
+            std::thread worker([&logger]() {
+                TTK_ASSERT(Logger::GetContext() == "");
+                logger.LogEvent("Other thread.");
+            });
+            worker.join();
+        }
+        logger.LogText("Text without prefix.\n");
+        logger.LogError("Some error.");
+    }
+    TTK_ASSERT(Logger::GetContext() == "");
+    logger.LogEvent("No context again.");
+
+    logger.CloseFile();
+
+    const std::string expected_text =
+        "[Event]: No context.\n"
+        "[Event][request=42]: Some event 1.\n"
+        "[Warning][request=42][session=7]: Some warning.\n"
+        "[Trace][Foo][request=42][session=7]: Some trace.\n"
+        "[Event]: Other thread.\n"
+        "Text without prefix.\n"
+        "[Error][request=42]: Some error.\n"
+        "[Event]: No context again.\n";
+
+    TTK_ASSERT(IsFileExists(file_name));
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name) + "\n" + expected_text);
+}
+
+// Creates socket of stand-in collector, bound to local port. Returns INVALID_SOCKET at failure.
+// address          Receives address of socket: "127.0.0.1:<port>".
+SOCKET CreateCollectorSocket(int type, std::string& address) {
+    SOCKET socket_handle = socket(AF_INET, type, 0);
+    if (socket_handle == INVALID_SOCKET) return INVALID_SOCKET;
+
+    sockaddr_in socket_address = {};
+    socket_address.sin_family       = AF_INET;
+    socket_address.sin_addr.s_addr  = htonl(INADDR_LOOPBACK);
+    socket_address.sin_port         = 0;
+
+    socklen_t socket_address_length = sizeof(socket_address);
+    if (bind(socket_handle, (sockaddr*)&socket_address, int(sizeof(socket_address))) != 0 || 
+            getsockname(socket_handle, (sockaddr*)&socket_address, &socket_address_length) != 0 ||
+            (type == SOCK_STREAM && listen(socket_handle, 1) != 0)) {
+        closesocket(socket_handle);
+        return INVALID_SOCKET;
+    }
+
+    address = "127.0.0.1:" + std::to_string(ntohs(socket_address.sin_port));
+    return socket_handle;
+}
+
+// Receives data from socket. Returns false if nothing is received within timeout.
+bool ReceiveFromSocket(SOCKET socket_handle, std::string& data, unsigned timeout_ms) {
+    fd_set read_set;
+    FD_ZERO(&read_set);
+    FD_SET(socket_handle, &read_set);
+
+    timeval timeout = {};
+    timeout.tv_sec  = long(timeout_ms / 1000);
+    timeout.tv_usec = long((timeout_ms % 1000) * 1000);
+
+    if (select(int(socket_handle + 1), &read_set, nullptr, nullptr, &timeout) <= 0) return false;
+
+    char buffer[65536];
+    const int count = recv(socket_handle, buffer, int(sizeof(buffer)), 0);
+    if (count <= 0) return false;
+
+    data.assign(buffer, count);
+    return true;
+}
+
+bool IsEndingWith(const std::string& text, const std::string& ending) {
+    return text.length() >= ending.length() && text.compare(text.length() - ending.length(), ending.length(), ending) == 0;
+}
+
+void TestLoggerSocket() {
+    WSADATA wsa_data;
+    TTK_ASSERT(WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0);
+
+    // UDP, syslog
+    {
+        std::string address;
+        SOCKET collector = CreateCollectorSocket(SOCK_DGRAM, address);
+        TTK_ASSERT(collector != INVALID_SOCKET);
+
+        Logger logger;
+        TTK_ASSERT(!logger.IsSocketOpened());
+        logger.OpenSocket(LoggerSocketType::UDP, address, LoggerSocketFraming::SYSLOG, 64 * 1024, "LoggerTest");
+        TTK_ASSERT(logger.IsSocketOpened());
+
+        logger.LogEvent("Some event %d.", 1);
+        logger.LogWarning("Some warning.");
+        logger.LogError("Some error.");
+
+        std::string messages[3];
+        for (auto& message : messages) TTK_ASSERT(ReceiveFromSocket(collector, message, 2000));
+
+        TTK_ASSERT_M(messages[0].find("<14>1 ") == 0, messages[0]);
+        TTK_ASSERT_M(messages[1].find("<12>1 ") == 0, messages[1]);
+        TTK_ASSERT_M(messages[2].find("<11>1 ") == 0, messages[2]);
+        TTK_ASSERT_M(messages[0].find(" LoggerTest ") != std::string::npos, messages[0]);
+        TTK_ASSERT_M(IsEndingWith(messages[0], " - - [Event]: Some event 1."), messages[0]);
+        TTK_ASSERT_M(IsEndingWith(messages[1], " - - [Warning]: Some warning."), messages[1]);
+        TTK_ASSERT_M(IsEndingWith(messages[2], " - - [Error]: Some error."), messages[2]);
+
+        logger.CloseSocket();
+        TTK_ASSERT(!logger.IsSocketOpened());
+        TTK_ASSERT(logger.GetSocketSentCount() == 3);
+        TTK_ASSERT(logger.GetSocketDroppedCount() == 0);
+
+        closesocket(collector);
+    }
+
+    // TCP, length prefixed, batched
+    {
+        std::string address;
+        SOCKET listener = CreateCollectorSocket(SOCK_STREAM, address);
+        TTK_ASSERT(listener != INVALID_SOCKET);
+
+        Logger logger;
+        logger.OpenSocket(LoggerSocketType::TCP, address, LoggerSocketFraming::LENGTH_PREFIXED);
+
+        enum { COUNT = 100 };
+        for (int index = 0; index < COUNT; ++index) logger.LogEvent("Some event %d.", index);
+        logger.Flush();
+
+        SOCKET collector = accept(listener, nullptr, nullptr);
+        TTK_ASSERT(collector != INVALID_SOCKET);
+
+        std::string data;
+        std::string received;
+        while (ReceiveFromSocket(collector, received, 2000)) {
+            data += received;
+            if (data.length() >= COUNT * 4) {
+                // Stops when all entries are received.
+                size_t offset = 0;
+                int count = 0;
+                while (offset + 4 <= data.length()) {
+                    const uint32_t length = uint32_t((unsigned char)data[offset]) | (uint32_t((unsigned char)data[offset + 1]) << 8) | 
+                        (uint32_t((unsigned char)data[offset + 2]) << 16) | (uint32_t((unsigned char)data[offset + 3]) << 24);
+                    if (offset + 4 + length > data.length()) break;
+                    offset += 4 + length;
+                    ++count;
+                }
+                if (count == COUNT) break;
+            }
+        }
+
+        size_t offset = 0;
+        for (int index = 0; index < COUNT; ++index) {
+            TTK_ASSERT(offset + 4 <= data.length());
+            const uint32_t length = uint32_t((unsigned char)data[offset]);
+            const std::string expected = "[Event]: Some event " + std::to_string(index) + ".\n";
+            TTK_ASSERT_M(data.compare(offset + 4, length, expected) == 0, data.substr(offset + 4, length));
+            offset += 4 + length;
+        }
+        TTK_ASSERT(offset == data.length());
+
+        logger.CloseSocket();
+        TTK_ASSERT(logger.GetSocketSentCount() == COUNT);
+
+        closesocket(collector);
+        closesocket(listener);
+    }
+
+    // Collector is down, entries which don't fit in buffer are dropped, logging doesn't block.
+    {
+        std::string address;
+        SOCKET listener = CreateCollectorSocket(SOCK_STREAM, address);
+        TTK_ASSERT(listener != INVALID_SOCKET);
+        closesocket(listener);
+
+        Logger logger;
+        logger.Enable(LoggerOption::COLLECT_STATS);
+        logger.OpenSocket(LoggerSocketType::TCP, address, LoggerSocketFraming::LENGTH_PREFIXED, 100);
+
+        enum { COUNT = 1000 };
+        const auto begin = std::chrono::steady_clock::now();
+        for (int index = 0; index < COUNT; ++index) logger.LogEvent("Some event %d.", index);
+        TTK_ASSERT(std::chrono::steady_clock::now() - begin < std::chrono::seconds(1));
+
+        TTK_ASSERT(logger.GetStats().dropped_count > 0);
+
+        logger.CloseSocket();
+        TTK_ASSERT(logger.GetSocketSentCount() == 0);
+        TTK_ASSERT(logger.GetSocketDroppedCount() == COUNT);
+    }
+
+    WSACleanup();
+}
+
+void TestLoggerIndexedFile() {
+    const std::string file_name = "log\\test\\TestLoggerIndexedFile.txt";
+    DeleteFileA(file_name.c_str());
+    DeleteFileA((file_name + ".idx").c_str());
+
+    Logger logger;
+    logger.OpenIndexedFile(file_name, false, 10);
+    TTK_ASSERT(logger.IsIndexedFileOpened());
+    TTK_ASSERT(logger.IsFileOpened());
+    logger.SetFileBatchSize(256);
+
+    // Three spans of 10 entries, logged in separate moments.
+    std::string texts[3];
+    std::chrono::system_clock::time_point times[4];
+    for (int span_index = 0; span_index < 3; ++span_index) {
+        times[span_index] = std::chrono::system_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        for (int index = 0; index < 10; ++index) {
+            if (index == 0) {
+                logger.LogWarning("Warning %d.", span_index);
+                texts[span_index] += "[Warning]: Warning " + std::to_string(span_index) + ".\n";
+            } else {
+                logger.LogEvent("Event %d.%d.", span_index, index);
+                texts[span_index] += "[Event]: Event " + std::to_string(span_index) + "." + std::to_string(index) + ".\n";
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    times[3] = std::chrono::system_clock::now();
+
+    // Incomplete span is written at closing, with time of its last entry.
+    logger.LogTrace("Foo", "Some trace.");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    logger.CloseFile();
+    TTK_ASSERT(!logger.IsIndexedFileOpened());
+
+    LoggerIndexedFileReader reader;
+    TTK_ASSERT(reader.Open(file_name));
+    TTK_ASSERT(reader.GetSpanCount() == 4);
+
+    TTK_ASSERT(reader.GetSpan(0).offset == 0);
+    TTK_ASSERT(reader.GetSpan(1).offset == texts[0].length());
+    TTK_ASSERT(reader.GetSpan(1).length == texts[1].length());
+    TTK_ASSERT(reader.GetSpan(1).entry_count == 10);
+    TTK_ASSERT(reader.GetSpan(1).warning_count == 1);
+    TTK_ASSERT(reader.GetSpan(1).event_count == 9);
+    TTK_ASSERT(reader.GetSpan(1).begin_time_ns <= reader.GetSpan(1).end_time_ns);
+    TTK_ASSERT(reader.GetSpan(3).entry_count == 1);
+    TTK_ASSERT(reader.GetSpan(3).trace_count == 1);
+    TTK_ASSERT(reader.GetSpan(3).end_time_ns == reader.GetSpan(3).begin_time_ns);
+
+    std::string text;
+    TTK_ASSERT(reader.ReadTimeRange(times[1], times[2], text));
+    TTK_ASSERT_M(text == texts[1], text);
+
+    TTK_ASSERT(reader.ReadTimeRange(times[0], times[2], text));
+    TTK_ASSERT_M(text == texts[0] + texts[1], text);
+
+    TTK_ASSERT(reader.ReadTimeRange(times[0] - std::chrono::hours(1), times[0], text));
+    TTK_ASSERT(text.empty());
+
+    reader.Close();
+
+    // Appending keeps index.
+    logger.OpenIndexedFile(file_name, true, 10);
+    logger.LogError("Some error.");
+    logger.CloseFile();
+
+    TTK_ASSERT(reader.Open(file_name));
+    TTK_ASSERT(reader.GetSpanCount() == 5);
+    TTK_ASSERT(reader.GetSpan(4).error_count == 1);
+    TTK_ASSERT(reader.GetSpan(4).offset == reader.GetSpan(3).offset + reader.GetSpan(3).length);
+
+    const std::string output_file_name = "log\\test\\TestLoggerIndexedFile_Range.txt";
+    TTK_ASSERT(LoggerIndexedFileReader::ExtractTimeRange(file_name, times[2], times[3], output_file_name));
+    TTK_ASSERT_M(LoadTextFromFile(output_file_name) == texts[2], LoadTextFromFile(output_file_name));
+
+    reader.Close();
+
+    // Span ends with first entry logged after time interval, which is taken from time prefix of entry.
+    logger.Enable(LoggerOption::LOG_TIME);
+    logger.OpenIndexedFile(file_name, false, 1000, 10);
+    logger.LogEvent("First.");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    logger.LogEvent("Second.");
+    logger.LogEvent("Third.");
+    logger.CloseFile();
+    logger.Disable(LoggerOption::LOG_TIME);
+
+    TTK_ASSERT(reader.Open(file_name));
+    TTK_ASSERT(reader.GetSpanCount() == 2);
+    TTK_ASSERT(reader.GetSpan(0).entry_count == 2);
+    TTK_ASSERT(reader.GetSpan(1).entry_count == 1);
+    TTK_ASSERT(reader.GetSpan(1).begin_time_ns >= reader.GetSpan(0).end_time_ns);
+    reader.Close();
+
+    // Without time prefix, time interval is checked at each 64-th entry of span.
+    logger.OpenIndexedFile(file_name, false, 1000, 10);
+    logger.LogEvent("First.");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int index = 0; index < 64; ++index) logger.LogEvent("Next.");
+    logger.CloseFile();
+
+    TTK_ASSERT(reader.Open(file_name));
+    TTK_ASSERT(reader.GetSpanCount() == 2);
+    TTK_ASSERT(reader.GetSpan(0).entry_count == 64);
+    TTK_ASSERT(reader.GetSpan(1).entry_count == 1);
+    TTK_ASSERT(reader.GetSpan(0).end_time_ns - reader.GetSpan(0).begin_time_ns >= 10000000);
+    reader.Close();
+
+    TTK_ASSERT(!reader.Open("log\\test\\NotExistingIndexedFile.txt"));
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.length())) ++count;
+    return count;
+}
+
+void TestLoggerBudget() {
+    const std::string file_name = "log\\test\\TestLoggerBudget.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.Enable(LoggerOption::COLLECT_STATS);
+    logger.SetBudget(2000);
+
+    enum { COUNT = 100 };
+    for (int index = 0; index < COUNT; ++index) {
+        logger.LogTrace("Foo", "Trace.");
+        logger.LogDump("Dump.");
+        logger.LogEvent("Event.");
+        logger.LogWarning("Warning.");
+    }
+    logger.LogError("Error.");
+
+    // Summary of shed entries is logged with first entry after end of second.
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    logger.LogEvent("Event after second.");
+
+    const LoggerStats stats = logger.GetStats();
+    logger.CloseFile();
+
+    const std::string text = LoadTextFromFile(file_name);
+
+    const size_t trace_count    = CountOccurrences(text, "[Trace][Foo]: Trace.\n");
+    const size_t dump_count     = CountOccurrences(text, "[Dump]: Dump.\n");
+    const size_t event_count    = CountOccurrences(text, "[Event]: Event.\n");
+
+    TTK_ASSERT(CountOccurrences(text, "[Warning]: Warning.\n") == COUNT);
+    TTK_ASSERT(CountOccurrences(text, "[Error]: Error.\n") == 1);
+    TTK_ASSERT_M(trace_count < dump_count && dump_count < event_count && event_count < COUNT, text);
+    TTK_ASSERT(stats.shed_count == (COUNT - trace_count) + (COUNT - dump_count) + (COUNT - event_count));
+
+    const std::string summary = "[Budget]: Shed entries: trace " + std::to_string(COUNT - trace_count) + 
+        ", dump " + std::to_string(COUNT - dump_count) + ", event " + std::to_string(COUNT - event_count) + ".\n";
+    TTK_ASSERT_M(IsEndingWith(text, summary + "[Event]: Event after second.\n"), text);
+
+    // Summary is logged also with entry, which can't be shed, and at closing file.
+    logger.OpenFile(file_name, false);
+
+    for (int index = 0; index < COUNT; ++index) logger.LogTrace("Foo", "Trace.");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    logger.LogWarning("Warning after second.");
+
+    for (int index = 0; index < COUNT; ++index) logger.LogTrace("Foo", "Trace.");
+    logger.CloseFile();
+
+    const std::string text_at_close = LoadTextFromFile(file_name);
+    TTK_ASSERT_M(CountOccurrences(text_at_close, "[Budget]: Shed entries: trace ") == 2, text_at_close);
+    TTK_ASSERT_M(text_at_close.find(", dump 0, event 0.\n[Warning]: Warning after second.\n") != std::string::npos, text_at_close);
+    TTK_ASSERT_M(IsEndingWith(text_at_close, ", dump 0, event 0.\n"), text_at_close);
+}
+
+void TestLoggerFormat() {
+    const std::string file_name = "log\\test\\TestLoggerFormat.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    // Message longer than stack buffer of formatting.
+    const std::string long_text(5000, 'x');
+    logger.LogEvent("Event %s.", long_text.c_str());
+
+    // Format as std::string.
+    const std::string format = "Dump %d.";
+    logger.LogDump(format, 7);
+    logger.LogTrace(std::string("Foo"), format, 8);
+
+    logger.CloseFile();
+
+    TTK_ASSERT(LoadTextFromFile(file_name) == "[Event]: Event " + long_text + ".\n[Dump]: Dump 7.\n[Trace][Foo]: Dump 8.\n");
+}
+
+void TraceCallSiteFoo(Logger& logger) {
+    LOGGER_TRACK(logger);
+    LOGGER_TRACE(logger, "Foo %d.", 1);
+}
+
+void TraceCallSiteBar(Logger& logger) {
+    LOGGER_TRACE(logger, "Bar.");
+}
+
+void TestLoggerCallSites() {
+    const std::string file_name = "log\\test\\TestLoggerCallSites.txt";
+    DeleteFileA(file_name.c_str());
+
+    TTK_ASSERT(Logger::IsMatchingPattern("TraceCallSiteFoo", "TraceCallSiteFoo"));
+    TTK_ASSERT(Logger::IsMatchingPattern("TraceCallSiteFoo", "*Site*"));
+    TTK_ASSERT(Logger::IsMatchingPattern("TraceCallSiteFoo", "TraceCallSiteF?o"));
+    TTK_ASSERT(Logger::IsMatchingPattern("main.cpp:42", "*.cpp:*"));
+    TTK_ASSERT(!Logger::IsMatchingPattern("TraceCallSiteFoo", "TraceCallSite"));
+    TTK_ASSERT(!Logger::IsMatchingPattern("TraceCallSiteFoo", "*Bar"));
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    // Rule is applied also to call site registered later.
+    Logger::DisableCallSites("TraceCallSiteBar");
+    TraceCallSiteFoo(logger);
+    TraceCallSiteBar(logger);
+
+    size_t foo_count = 0;
+    size_t bar_count = 0;
+    for (const LoggerCallSite* call_site : Logger::GetCallSites()) {
+        if (std::string(call_site->GetFunctionName()) == "TraceCallSiteFoo") {
+            TTK_ASSERT(call_site->IsEnabled());
+            ++foo_count;
+        } else if (std::string(call_site->GetFunctionName()) == "TraceCallSiteBar") {
+            TTK_ASSERT(!call_site->IsEnabled());
+            TTK_ASSERT(std::string(call_site->GetCategoryName()) == "Trace");
+            TTK_ASSERT(call_site->GetLine() > 0);
+            ++bar_count;
+        }
+    }
+    TTK_ASSERT(foo_count == 2);
+    TTK_ASSERT(bar_count == 1);
+
+    Logger::DisableCallSites("*main.cpp:*");
+    Logger::EnableCallSites("TraceCallSiteB?r");
+    TraceCallSiteFoo(logger);
+    TraceCallSiteBar(logger);
+
+    // Category still filters entries of enabled call site.
+    Logger::EnableCallSites("*");
+    logger.Disable(LoggerOption::LOG_TRACE);
+    TraceCallSiteBar(logger);
+    logger.Enable(LoggerOption::LOG_TRACE);
+    TraceCallSiteBar(logger);
+
+    logger.CloseFile();
+
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == 
+        "[Trace][TraceCallSiteFoo]: Enter.\n"
+        "[Trace][TraceCallSiteFoo]: Foo 1.\n"
+        "[Trace][TraceCallSiteFoo]: Exit.\n"
+        "[Trace][TraceCallSiteBar]: Bar.\n"
+        "[Trace][TraceCallSiteBar]: Bar.\n", LoadTextFromFile(file_name));
+}
+
+void TestLoggerMetrics() {
+    const std::string file_name = "log\\test\\TestLoggerMetrics.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    const size_t requests       = logger.RegisterMetric("requests", LoggerMetricType::COUNTER);
+    const size_t queue_depth    = logger.RegisterMetric("queue_depth", LoggerMetricType::GAUGE);
+    const size_t latency        = logger.RegisterMetric("latency_us", LoggerMetricType::HISTOGRAM);
+    TTK_ASSERT(logger.RegisterMetric("requests", LoggerMetricType::COUNTER) == requests);
+    TTK_ASSERT(requests != queue_depth && queue_depth != latency);
+
+    // Samples from 1 to 100, half of them from each thread.
+    auto record = [&](int first) {
+        for (int value = first; value <= 100; value += 2) {
+            logger.RecordMetric(requests, 1);
+            logger.RecordMetric(latency, value);
+        }
+    };
+    std::thread thread(record, 1);
+    record(2);
+    thread.join();
+
+    logger.RecordMetric(queue_depth, 9);
+    logger.RecordMetric(queue_depth, 1);
+    logger.RecordMetric(queue_depth, 4);
+
+    logger.FlushMetrics();
+
+    // Nothing is recorded since previous flush.
+    logger.FlushMetrics();
+
+    logger.RecordMetric(requests, 5);
+    logger.FlushMetrics();
+
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == 
+        "[Metric]: requests (counter): count 100, sum 100.\n"
+        "[Metric]: queue_depth (gauge): count 3, last 4, min 1, max 9.\n"
+        "[Metric]: latency_us (histogram): count 100, sum 5050, min 1, max 100, p50 50, p90 92, p99 100.\n"
+        "[Metric]: requests (counter): count 1, sum 5.\n", LoadTextFromFile(file_name));
+
+    // Background tick.
+    logger.SetMetricInterval(10);
+    logger.RecordMetric(requests, 1);
+    for (int index = 0; index < 100 && LoadTextFromFile(file_name).find("count 1, sum 1.") == std::string::npos; ++index) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    logger.SetMetricInterval(0);
+
+    logger.CloseFile();
+
+    TTK_ASSERT(LoadTextFromFile(file_name).find("[Metric]: requests (counter): count 1, sum 1.\n") != std::string::npos);
+
+    // Thread exits after logger, to which it recorded, is destroyed.
+    {
+        std::unique_ptr<Logger> temporary_logger(new Logger());
+        const size_t events = temporary_logger->RegisterMetric("events", LoggerMetricType::HISTOGRAM);
+
+        std::atomic<bool> is_recorded(false);
+        std::atomic<bool> is_destroyed(false);
+        std::thread recording_thread([&]() {
+            temporary_logger->RecordMetric(events, 1);
+            is_recorded = true;
+            while (!is_destroyed) std::this_thread::yield();
+        });
+
+        while (!is_recorded) std::this_thread::yield();
+        temporary_logger.reset();
+        is_destroyed = true;
+        recording_thread.join();
+    }
+}
+
+void TestLoggerSpans() {
+    const std::string file_name = "log\\test\\TestLoggerSpans.txt";
+    DeleteFileA(file_name.c_str());
+
+    // unbatched
+    {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.Enable(LoggerOption::COLLECT_STATS);
+
+        const char buffer[] = "Buffer.\nNot logged.";
+        logger.LogBuffer(buffer, 8);
+        logger.LogBuffer("Format %d %s.\n", 14);
+
+        const std::string body = "{\"key\": 1}";
+        logger.LogSpans({{"[Json]: ", 8}, {body.c_str(), body.length()}, {"\n", 1}});
+        logger.LogSpans(nullptr, 0);
+
+        const LoggerStats stats = logger.GetStats();
+        TTK_ASSERT(stats.text.entry_count == 4);
+        TTK_ASSERT(stats.text.byte_count == 8 + 14 + 8 + body.length() + 1);
+
+        logger.CloseFile();
+
+        TTK_ASSERT_M(LoadTextFromFile(file_name) == "Buffer.\nFormat %d %s.\n[Json]: {\"key\": 1}\n", LoadTextFromFile(file_name));
+    }
+
+    // batched, entry which doesn't fit in batch is written after batched ones
+    {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.SetFileBatchSize(64);
+
+        logger.LogDump("Dump.");
+        TTK_ASSERT(LoadTextFromFile(file_name) == "");
+
+        logger.LogSpans({{"Small", 5}, {" spans.\n", 8}});
+        TTK_ASSERT(LoadTextFromFile(file_name) == "");
+
+        const std::string large(100, 'x');
+        logger.LogSpans({{large.c_str(), large.length()}, {"\n", 1}});
+        TTK_ASSERT_M(LoadTextFromFile(file_name) == "[Dump]: Dump.\nSmall spans.\n" + large + "\n", LoadTextFromFile(file_name));
+
+        logger.CloseFile();
+    }
+
+    // sanitized, also when utf-8 sequence is split between spans
+    {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.Enable(LoggerOption::SANITIZE_UTF8);
+
+        logger.LogSpans({{"Split \xD1", 7}, {"\x84.\n", 3}});
+        logger.LogSpans({{"Invalid \xFF", 9}, {".\n", 2}});
+
+        logger.CloseFile();
+
+        TTK_ASSERT_M(LoadTextFromFile(file_name) == u8"Split \u0444.\nInvalid \uFFFD.\n", LoadTextFromFile(file_name));
+    }
+}
+
+struct TestPoint {
+    int x;
+    int y;
+};
+
+template <>
+struct LoggerFormatter<TestPoint> {
+    static void Append(std::string& text, const TestPoint& point) {
+        text += '{';
+        LoggerFormatter<int>::Append(text, point.x);
+        text += ' ';
+        LoggerFormatter<int>::Append(text, point.y);
+        text += '}';
+    }
+};
+
+namespace TestColors {
+    struct Color {
+        int red;
+        int green;
+        int blue;
+    };
+
+    void LoggerAppend(std::string& text, const Color& color) {
+        text += "rgb(";
+        LoggerFormatter<int>::Append(text, color.red);
+        text += ", ";
+        LoggerFormatter<int>::Append(text, color.green);
+        text += ", ";
+        LoggerFormatter<int>::Append(text, color.blue);
+        text += ')';
+    }
+
+    enum class Mode {
+        FAST = 1,
+        SLOW = 2
+    };
+}
+
+void TestLoggerFormatter() {
+    const std::string file_name = "log\\test\\TestLoggerFormatter.txt";
+    DeleteFileA(file_name.c_str());
+
+    std::string text;
+    LoggerFormatter<int64_t>::Append(text, INT64_MIN);
+    text += ' ';
+    LoggerFormatter<uint64_t>::Append(text, UINT64_MAX);
+    TTK_ASSERT_M(text == "-9223372036854775808 18446744073709551615", text);
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    logger.LogEvent("Point %s.", TestPoint{1, -2});
+    logger.LogEvent("Color %s, %d%%, %s.", TestColors::Color{1, 2, 3}, 50, std::string("text"));
+    logger.LogDump("Vector %s, map %s.", std::vector<int>{1, 2, 3}, std::map<std::string, int>{{"a", 1}, {"b", 2}});
+    logger.LogDump("Pair %s, optional %s %s.", std::make_pair(1, 2.5), std::optional<int>(7), std::optional<int>());
+    logger.LogWarning("Mode %s %d, bool %s, %5.2f, %s.", TestColors::Mode::SLOW, TestColors::Mode::FAST, true, 1.5, 42);
+    logger.LogTrace("Foo", "Points %s.", std::vector<TestPoint>{{1, 2}, {3, 4}});
+    logger.LogText("Text %s, missing %d.\n", std::string("a"));
+    logger.LogHexDump("ab", 2, "Data %s.", std::string("x"));
+
+    logger.CloseFile();
+
+    const std::string expected_text = 
+        "[Event]: Point {1 -2}.\n"
+        "[Event]: Color rgb(1, 2, 3), 50%, text.\n"
+        "[Dump]: Vector [1, 2, 3], map [(a, 1), (b, 2)].\n"
+        "[Dump]: Pair (1, 2.5), optional 7 nullopt.\n"
+        "[Warning]: Mode 2 1, bool true,  1.50, 42.\n"
+        "[Trace][Foo]: Points [{1 2}, {3 4}].\n"
+        "Text a, missing %d.\n"
+        "[Dump]: Data x.\n"
+        "00000000  61 62                                             |ab|\n";
+
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name));
+}
+
+void TestLoggerMessageFunction() {
+    const std::string file_name = "log\\test\\TestLoggerMessageFunction.txt";
+    DeleteFileA(file_name.c_str());
+
+    TTK_ASSERT((LoggerIsMessageFunction<void (*)(std::string&)>::value));
+    TTK_ASSERT((LoggerIsMessageFunction<std::string (*)()>::value));
+    TTK_ASSERT((!LoggerIsMessageFunction<void (*)()>::value));
+    TTK_ASSERT((!LoggerIsMessageFunction<const char*>::value));
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    int call_count = 0;
+
+    logger.LogDump([&](std::string& text) { 
+        ++call_count; 
+        text += "Dump "; 
+        LoggerFormatter<int>::Append(text, 1); 
+    });
+    logger.LogEvent([&]() { ++call_count; return std::string("Event."); });
+    logger.LogTrace("Foo", [&]() { ++call_count; return std::vector<int>{1, 2}; });
+    logger.LogWarning([&]() { ++call_count; return "Warning."; });
+    TTK_ASSERT(call_count == 4);
+
+    // Function isn't called for filtered out entry.
+    logger.Disable(LoggerOption::LOG_DUMP);
+    logger.LogDump([&](std::string& text) { ++call_count; text += "Disabled."; });
+    logger.SetMinSeverity(LoggerCategory::Warning::SEVERITY);
+    logger.LogEvent([&]() { ++call_count; return "Below minimal severity."; });
+    TTK_ASSERT(call_count == 4);
+
+    logger.CloseFile();
+
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == "[Dump]: Dump 1\n[Event]: Event.\n[Trace][Foo]: [1, 2]\n[Warning]: Warning.\n", LoadTextFromFile(file_name));
+}
+
+void TestLoggerAsyncStdOut() {
+    // bare open/close
+    {
+        Logger logger;
+        TTK_ASSERT(!logger.IsAsyncStdOutOpened());
+        logger.OpenAsyncStdOut();
+        TTK_ASSERT(logger.IsAsyncStdOutOpened());
+        logger.CloseAsyncStdOut();
+        TTK_ASSERT(!logger.IsAsyncStdOutOpened());
+    }
+
+    // sink
+    {
+        LoggerConsoleSink sink;
+        sink.Open(16, false);
+        TTK_ASSERT(sink.Push("", 0, LoggerCategory::Event::SEVERITY));
+        TTK_ASSERT(!sink.Push("Entry longer than buffer.\n", 26, LoggerCategory::Event::SEVERITY));
+        sink.Close();
+        TTK_ASSERT(sink.GetWrittenCount() == 1);
+        TTK_ASSERT(sink.GetDroppedCount() == 1);
+    }
+
+    // dropped entry
+    {
+        Logger logger;
+        logger.Enable(LoggerOption::COLLECT_STATS);
+        logger.OpenAsyncStdOut(8);
+        logger.LogText("Entry longer than buffer.\n");
+        TTK_ASSERT(logger.GetAsyncStdOutDroppedCount() == 1);
+        TTK_ASSERT(logger.GetStats().dropped_count == 1);
+        logger.CloseAsyncStdOut();
+    }
+
+    // log text
+    {
+        system(".\\Logger_Test.exe LOG_ASYNC_STDOUT > .\\log\\test\\TestLoggerAsyncStdOut.txt");
+        const std::string expected_text = "Text.\n[Event]: Event.\n\x1B[33m[Warning]: Warning.\x1B[0m\n\x1B[90m[Dump]: Dump.\x1B[0m\n";
+        TTK_ASSERT_M(LoadTextFromFile(".\\log\\test\\TestLoggerAsyncStdOut.txt") == expected_text, LoadTextFromFile(".\\log\\test\\TestLoggerAsyncStdOut.txt"));
+    }
+
+    // entries waiting in buffer are written before exit at fatal error
+    {
+        system(".\\Logger_Test.exe FATAL_ERROR_ASYNC_STDOUT > .\\log\\test\\TestLoggerAsyncStdOut_FATAL_ERROR.txt");
+        const std::string expected_text = "[Event]: Event.\n[Fatal Error]: Some text.\n";
+        TTK_ASSERT_M(LoadTextFromFile(".\\log\\test\\TestLoggerAsyncStdOut_FATAL_ERROR.txt") == expected_text, LoadTextFromFile(".\\log\\test\\TestLoggerAsyncStdOut_FATAL_ERROR.txt"));
+    }
+}
+
+void SlowScopeInner(Logger& logger, int sleep_ms) {
+    LOGGER_TRACK_SLOW(logger, std::chrono::milliseconds(20));
+    if (sleep_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+}
+
+void SlowScopeOuter(Logger& logger, int sleep_ms) {
+    LOGGER_TRACK_SLOW(logger, std::chrono::seconds(10));
+    SlowScopeInner(logger, sleep_ms);
+}
+
+void SlowScopeTracked(Logger& logger, int sleep_ms) {
+    LOGGER_TRACK(logger);
+    SlowScopeInner(logger, sleep_ms);
+}
+
+void TestLoggerSlowScope() {
+    const std::string file_name = "log\\test\\TestLoggerSlowScope.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    SlowScopeOuter(logger, 0);
+    TTK_ASSERT(LoadTextFromFile(file_name) == "");
+
+    SlowScopeOuter(logger, 30);
+    std::string text = LoadTextFromFile(file_name);
+    TTK_ASSERT_M(text.find("[Slow Scope]: SlowScopeInner took ") == 0, text);
+    TTK_ASSERT_M(text.find(" ms (threshold 20.000 ms), path: SlowScopeOuter > SlowScopeInner.\n") != std::string::npos, text);
+    TTK_ASSERT(std::count(text.begin(), text.end(), '\n') == 1);
+
+    // Scope of LOGGER_TRACK is part of path.
+    SlowScopeTracked(logger, 30);
+
+    logger.CloseFile();
+
+    text = LoadTextFromFile(file_name);
+    TTK_ASSERT_M(text.find("[Trace][SlowScopeTracked]: Enter.\n[Slow Scope]: SlowScopeInner took ") != std::string::npos, text);
+    TTK_ASSERT_M(text.find("path: SlowScopeTracked > SlowScopeInner.\n[Trace][SlowScopeTracked]: Exit.\n") != std::string::npos, text);
+}
+
+void TestLoggerDumpProviders() {
+    const std::string file_name = "log\\test\\TestLoggerDumpProviders.txt";
+    DeleteFileA(file_name.c_str());
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    std::atomic<int> cache_call_count(0);
+    const size_t cache_id = logger.RegisterDumpProvider("cache", 10000, [&](std::string& text) { 
+        ++cache_call_count; 
+        text += "size 10."; 
+    });
+    logger.RegisterDumpProvider("connections", 10000, [](std::string& text) { text += "open 2."; });
+
+    logger.FlushDumpProviders();
+    std::string expected_text = "[Dump]: cache: size 10.\n[Dump]: connections: open 2.\n";
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name));
+
+    // Providers aren't called while dump is disabled, their entries are counted as suppressed.
+    logger.Enable(LoggerOption::COLLECT_STATS);
+    logger.Disable(LoggerOption::LOG_DUMP);
+    logger.FlushDumpProviders();
+    TTK_ASSERT(cache_call_count == 1);
+    TTK_ASSERT(logger.GetStats().suppressed_count == 2);
+    logger.Enable(LoggerOption::LOG_DUMP);
+    logger.Disable(LoggerOption::COLLECT_STATS);
+
+    logger.UnregisterDumpProvider(cache_id);
+    logger.FlushDumpProviders();
+    expected_text += "[Dump]: connections: open 2.\n";
+    TTK_ASSERT_M(LoadTextFromFile(file_name) == expected_text, LoadTextFromFile(file_name));
+
+    // background thread
+    std::atomic<int> tick_count(0);
+    const size_t tick_id = logger.RegisterDumpProvider("tick", 1, [&](std::string& text) { 
+        ++tick_count; 
+        text += "tick."; 
+    });
+    for (int index = 0; index < 1000 && tick_count < 3; ++index) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    TTK_ASSERT(tick_count >= 3);
+
+    logger.UnregisterDumpProvider(tick_id);
+    const int unregistered_tick_count = tick_count;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TTK_ASSERT(tick_count == unregistered_tick_count);
+
+    logger.CloseFile();
+
+    const std::string text = LoadTextFromFile(file_name);
+    TTK_ASSERT_M(text.find(expected_text + "[Dump]: tick: tick.\n") == 0, text);
+
+    // Each provider gives separate entry to output.
+    {
+        const std::string indexed_file_name = "log\\test\\TestLoggerDumpProviders_Indexed.txt";
+
+        Logger indexed_logger;
+        indexed_logger.OpenIndexedFile(indexed_file_name, false);
+        indexed_logger.RegisterDumpProvider("cache", 10000, [](std::string& text) { text += "size 10."; });
+        indexed_logger.RegisterDumpProvider("connections", 10000, [](std::string& text) { text += "open 2."; });
+        indexed_logger.FlushDumpProviders();
+        indexed_logger.CloseFile();
+
+        LoggerIndexedFileReader reader;
+        TTK_ASSERT(reader.Open(indexed_file_name));
+        TTK_ASSERT(reader.GetSpanCount() == 1);
+        TTK_ASSERT(reader.GetSpan(0).entry_count == 2 && reader.GetSpan(0).dump_count == 2);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename FunctionType>
+double MeasureSeconds(FunctionType function) {
+    const auto begin = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void BenchmarkSanitizeUTF8() {
+    enum { COUNT = 200000 };
+
+    const std::string ascii_text    = "Some ascii message with a number 12345 and some more words in it.";
+    const std::string utf8_text     = u8"Some utf-8 message \u0444\u0444\u0444 with a number 12345 \u20AC\u20AC.";
+
+    size_t valid_count = 0;
+    const double ascii_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) valid_count += Logger::IsValidUTF8(ascii_text);
+    });
+    const double utf8_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) valid_count += Logger::IsValidUTF8(utf8_text);
+    });
+
+    printf("IsValidUTF8 (ascii):    %8.2f MB/s\n", (ascii_text.length() * double(COUNT)) / ascii_seconds / 1e6);
+    printf("IsValidUTF8 (utf-8):    %8.2f MB/s\n", (utf8_text.length() * double(COUNT)) / utf8_seconds / 1e6);
+
+    const std::string file_name = "log\\test\\BenchmarkSanitizeUTF8.txt";
+
+    auto LogEntries = [&](bool is_sanitize) {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.SetOption(LoggerOption::SANITIZE_UTF8, is_sanitize);
+        return MeasureSeconds([&]() {
+            for (size_t index = 0; index < COUNT / 10; ++index) logger.LogEvent("%s %d", utf8_text.c_str(), int(index));
+        });
+    };
+
+    const double plain_seconds      = LogEntries(false);
+    const double sanitize_seconds   = LogEntries(true);
+
+    printf("LogEvent:               %8.2f ns/entry\n", plain_seconds * 1e9 / (COUNT / 10));
+    printf("LogEvent (sanitized):   %8.2f ns/entry\n", sanitize_seconds * 1e9 / (COUNT / 10));
+
+    if (valid_count != 2 * COUNT) printf("Unexpected validation result.\n");
+}
+
+void BenchmarkFileBatch() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkFileBatch.txt";
+
+    auto LogEntries = [&](size_t batch_size) {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.SetFileBatchSize(batch_size);
+        return MeasureSeconds([&]() {
+            for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Some event message %d.", int(index));
+            logger.Flush();
+        });
+    };
+
+    printf("LogEvent (unbatched):   %8.2f ns/entry\n", LogEntries(0) * 1e9 / COUNT);
+    printf("LogEvent (batch 4KB):   %8.2f ns/entry\n", LogEntries(4 * 1024) * 1e9 / COUNT);
+    printf("LogEvent (batch 64KB):  %8.2f ns/entry\n", LogEntries(64 * 1024) * 1e9 / COUNT);
+}
+
+void BenchmarkStats() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkStats.txt";
+
+    auto LogEntries = [&](bool is_collect_stats) {
+        Logger logger;
+        logger.OpenFile(file_name, false);
+        logger.SetFileBatchSize(64 * 1024);
+        logger.SetOption(LoggerOption::COLLECT_STATS, is_collect_stats);
+        return MeasureSeconds([&]() {
+            for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Some event message %d.", int(index));
+            logger.Flush();
+        });
+    };
+
+    printf("LogEvent (no stats):    %8.2f ns/entry\n", LogEntries(false) * 1e9 / COUNT);
+    printf("LogEvent (stats):       %8.2f ns/entry\n", LogEntries(true) * 1e9 / COUNT);
+}
+
+void BenchmarkHexDump() {
+    enum { COUNT = 1000, SIZE = 4096 };
+
+    std::vector<unsigned char> data(SIZE);
+    for (size_t index = 0; index < data.size(); ++index) data[index] = (unsigned char)(index * 31);
+
+    const std::string file_name = "log\\test\\BenchmarkHexDump.txt";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64 * 1024);
+
+    const double snprintf_seconds = MeasureSeconds([&]() {
+        for (size_t count = 0; count < COUNT; ++count) {
+            std::string text;
+            char buffer[4];
+            for (size_t index = 0; index < data.size(); ++index) {
+                snprintf(buffer, sizeof(buffer), "%02X ", data[index]);
+                text += buffer;
+            }
+            logger.LogDump("Frame: %s", text.c_str());
+        }
+        logger.Flush();
+    });
+    const double hex_dump_seconds = MeasureSeconds([&]() {
+        for (size_t count = 0; count < COUNT; ++count) logger.LogHexDump(data.data(), data.size(), "Frame:");
+        logger.Flush();
+    });
+
+    printf("LogDump 4KB (snprintf): %8.2f us/entry\n", snprintf_seconds * 1e6 / COUNT);
+    printf("LogHexDump 4KB:         %8.2f us/entry\n", hex_dump_seconds * 1e6 / COUNT);
+}
+
+void BenchmarkCategories() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkCategories.txt";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64 * 1024);
+
+    const double event_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Some event message %d.", int(index));
+        logger.Flush();
+    });
+    const double audit_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.Log<Audit>("Some audit message %d.", int(index));
+        logger.Flush();
+    });
+
+    logger.Disable<Audit>();
+    const double disabled_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.Log<Audit>("Some audit message %d.", int(index));
+    });
+
+    printf("LogEvent:               %8.2f ns/entry\n", event_seconds * 1e9 / COUNT);
+    printf("Log<Audit>:             %8.2f ns/entry\n", audit_seconds * 1e9 / COUNT);
+    printf("Log<Audit> (disabled):  %8.2f ns/entry\n", disabled_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkContext() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkContext.txt";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64 * 1024);
+
+    const std::string request_id = "3f2a9c7e-1b4d-4e8f-9a6b-5c0d2e7f8a1b";
+    const std::string session_id = "session-000123456";
+
+    const double format_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) {
+            logger.LogEvent("[request=%s][session=%s] Some event message %d.", request_id.c_str(), session_id.c_str(), int(index));
+        }
+        logger.Flush();
+    });
+
+    Logger::Context request_context("request", request_id);
+    Logger::Context session_context("session", session_id);
+    const double context_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Some event message %d.", int(index));
+        logger.Flush();
+    });
+
+    printf("LogEvent (ids in format):   %8.2f ns/entry\n", format_seconds * 1e9 / COUNT);
+    printf("LogEvent (ids in context):  %8.2f ns/entry\n", context_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkIndexedFile() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkIndexedFile.txt";
+
+    auto LogEntries = [&](bool is_indexed) {
+        Logger logger;
+        if (is_indexed) {
+            logger.OpenIndexedFile(file_name, false);
+        } else {
+            logger.OpenFile(file_name, false);
+        }
+        logger.SetFileBatchSize(64 * 1024);
+        return MeasureSeconds([&]() {
+            for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Some event message %d.", int(index));
+            logger.Flush();
+        });
+    };
+
+    printf("LogEvent (file):        %8.2f ns/entry\n", LogEntries(false) * 1e9 / COUNT);
+    printf("LogEvent (indexed):     %8.2f ns/entry\n", LogEntries(true) * 1e9 / COUNT);
+}
+
+void BenchmarkTraceCallSite(Logger& logger, int index) {
+    LOGGER_TRACE(logger, "Some trace message %d.", index);
+}
+
+void BenchmarkCallSites() {
+    enum { COUNT = 1000000 };
+
+    const std::string file_name = "log\\test\\BenchmarkCallSites.txt";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    logger.Disable(LoggerOption::LOG_TRACE);
+    const double category_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) BenchmarkTraceCallSite(logger, int(index));
+    });
+    logger.Enable(LoggerOption::LOG_TRACE);
+
+    Logger::DisableCallSites("BenchmarkTraceCallSite");
+    const double call_site_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) BenchmarkTraceCallSite(logger, int(index));
+    });
+    Logger::EnableCallSites("*");
+
+    printf("LOGGER_TRACE (LOG_TRACE disabled):  %8.2f ns/entry\n", category_seconds * 1e9 / COUNT);
+    printf("LOGGER_TRACE (call site disabled):  %8.2f ns/entry\n", call_site_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkMetrics() {
+    enum { COUNT = 1000000 };
+
+    const std::string file_name = "log\\test\\BenchmarkMetrics.txt";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64 * 1024);
+
+    const double dump_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogDump("queue depth %d", int(index % 1000));
+        logger.Flush();
+    });
+
+    const size_t queue_depth = logger.RegisterMetric("queue_depth", LoggerMetricType::HISTOGRAM);
+    logger.SetMetricInterval(100);
+    const double metric_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.RecordMetric(queue_depth, int64_t(index % 1000));
+    });
+    logger.SetMetricInterval(0);
+    logger.FlushMetrics();
+
+    printf("LogDump (value):        %8.2f ns/value\n", dump_seconds * 1e9 / COUNT);
+    printf("RecordMetric:           %8.2f ns/value\n", metric_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkSpans() {
+    enum { COUNT = 1000 };
+
+    const std::string file_name = "log\\test\\BenchmarkSpans.txt";
+
+    // Pre-formatted payload, like serialized json.
+    std::string body = "{\"values\": [";
+    while (body.length() < 256 * 1024) body += "123456789, ";
+    body += "0]}\n";
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+
+    const double format_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogText("[Json]: %s", body.c_str());
+    });
+    const double text_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogText("[Json]: " + body);
+    });
+    const double spans_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogSpans({{"[Json]: ", 8}, {body.c_str(), body.length()}});
+    });
+
+    printf("LogText (format, 256KB):    %8.2f us/entry\n", format_seconds * 1e6 / COUNT);
+    printf("LogText (string, 256KB):    %8.2f us/entry\n", text_seconds * 1e6 / COUNT);
+    printf("LogSpans (256KB):           %8.2f us/entry\n", spans_seconds * 1e6 / COUNT);
+}
+
+void BenchmarkFormatter() {
+    enum { COUNT = 100000 };
+
+    const std::string file_name = "log\\test\\BenchmarkFormatter.txt";
+
+    const std::vector<int> values = {1, 22, 333, 4444, 55555, 666666, 7777777, 88888888};
+
+    // Conversion by temporary string, passed to '%s'.
+    auto ToString = [](const std::vector<int>& values) {
+        std::string text = "[";
+        for (size_t index = 0; index < values.size(); ++index) {
+            if (index > 0) text += ", ";
+            text += std::to_string(values[index]);
+        }
+        return text + "]";
+    };
+
+    Logger logger;
+    logger.OpenFile(file_name, false);
+    logger.SetFileBatchSize(64 * 1024);
+
+    const double string_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Values %s.", ToString(values).c_str());
+        logger.Flush();
+    });
+    const double formatter_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) logger.LogEvent("Values %s.", values);
+        logger.Flush();
+    });
+
+    printf("LogEvent (ToString):    %8.2f ns/entry\n", string_seconds * 1e9 / COUNT);
+    printf("LogEvent (formatter):   %8.2f ns/entry\n", formatter_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkMessageFunction() {
+    enum { COUNT = 100000 };
+
+    const std::vector<int> values(64, 12345);
+
+    Logger logger;
+    logger.Disable(LoggerOption::LOG_DUMP);
+
+    const double eager_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) {
+            std::string text;
+            for (int value : values) text += std::to_string(value) + " ";
+            logger.LogDump("%s", text.c_str());
+        }
+    });
+    const double lazy_seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) {
+            logger.LogDump([&](std::string& text) {
+                for (int value : values) text += std::to_string(value) + " ";
+            });
+        }
+    });
+
+    printf("LogDump disabled (eager):    %8.2f ns/entry\n", eager_seconds * 1e9 / COUNT);
+    printf("LogDump disabled (function): %8.2f ns/entry\n", lazy_seconds * 1e9 / COUNT);
+}
+
+void BenchmarkSlowScope() {
+    enum { COUNT = 1000000 };
+
+    Logger logger;
+
+    const double seconds = MeasureSeconds([&]() {
+        for (size_t index = 0; index < COUNT; ++index) SlowScopeInner(logger, 0);
+    });
+
+    printf("LOGGER_TRACK_SLOW (fast):   %8.2f ns/scope\n", seconds * 1e9 / COUNT);
+}
+
 //------------------------------------------------------------------------------
 
 int main(int argc, char *argv[]) {
@@ -491,10 +2263,65 @@ int main(int argc, char *argv[]) {
         logger.CloseStdOut();
         logger.LogText("And another text.");
         return 0;
+    } else if (IsFlag("LOG_ASYNC_STDOUT")) {
+        Logger logger;
+        logger.OpenAsyncStdOut(1024 * 1024, true);
+        logger.LogText("Text.\n");
+        logger.LogEvent("Event.");
+        logger.LogWarning("Warning.");
+        logger.LogDump("Dump.");
+        return 0;
+    } else if (IsFlag("FATAL_ERROR_ASYNC_STDOUT")) {
+        Logger logger;
+        logger.OpenAsyncStdOut();
+        logger.LogEvent("Event.");
+        logger.LogFatalError("Some text.");
+        logger.LogText("This shouldn't get through.");
+        return 0;
+    } else if (IsFlag("BENCHMARK")) {
+        TTK_ASSERT(CreateDirectoryA(".\\log", 0) || GetLastError() == ERROR_ALREADY_EXISTS);
+        TTK_ASSERT(CreateDirectoryA(".\\log\\test", 0) || GetLastError() == ERROR_ALREADY_EXISTS);
+
+        BenchmarkSanitizeUTF8();
+        BenchmarkFileBatch();
+        BenchmarkStats();
+        BenchmarkHexDump();
+        BenchmarkCategories();
+        BenchmarkContext();
+        BenchmarkIndexedFile();
+        BenchmarkCallSites();
+        BenchmarkMetrics();
+        BenchmarkSpans();
+        BenchmarkFormatter();
+        BenchmarkMessageFunction();
+        BenchmarkSlowScope();
+        return 0;
     } else {
         TTK_ADD_TEST(TestLoggerOpenCloseFile, 0);
         TTK_ADD_TEST(TestLoggerOpenCloseStdOut, 0);
         TTK_ADD_TEST(TestLoggerLog, 0);
+        TTK_ADD_TEST(TestLoggerSanitizeUTF8, 0);
+        TTK_ADD_TEST(TestLoggerFileBatch, 0);
+        TTK_ADD_TEST(TestLoggerRegistry, 0);
+        TTK_ADD_TEST(TestLoggerStats, 0);
+        TTK_ADD_TEST(TestLoggerHexDump, 0);
+        TTK_ADD_TEST(TestLoggerCompressedFile, 0);
+        TTK_ADD_TEST(TestLoggerSharedMemory, 0);
+        TTK_ADD_TEST(TestLoggerShardedFiles, 0);
+        TTK_ADD_TEST(TestLoggerCategories, 0);
+        TTK_ADD_TEST(TestLoggerContext, 0);
+        TTK_ADD_TEST(TestLoggerSocket, 0);
+        TTK_ADD_TEST(TestLoggerIndexedFile, 0);
+        TTK_ADD_TEST(TestLoggerBudget, 0);
+        TTK_ADD_TEST(TestLoggerFormat, 0);
+        TTK_ADD_TEST(TestLoggerCallSites, 0);
+        TTK_ADD_TEST(TestLoggerMetrics, 0);
+        TTK_ADD_TEST(TestLoggerSpans, 0);
+        TTK_ADD_TEST(TestLoggerFormatter, 0);
+        TTK_ADD_TEST(TestLoggerMessageFunction, 0);
+        TTK_ADD_TEST(TestLoggerAsyncStdOut, 0);
+        TTK_ADD_TEST(TestLoggerSlowScope, 0);
+        TTK_ADD_TEST(TestLoggerDumpProviders, 0);
         return !TTK_Run();
     }
 }
\ No newline at end of file
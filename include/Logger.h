@@ -32,16 +32,75 @@
 #define LOGGER_H_
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <locale.h>
+#include <stdarg.h>
 
-#define WIN32_LEAN_AND_MEAN 
-#include <windows.h>
-#undef WIN32_LEAN_AND_MEAN 
+// In compiled mode (LOGGER_COMPILED_LIB), definitions which aren't templates are compiled once into Logger library 
+// and windows.h isn't included by this header.
+#ifndef LOGGER_COMPILED_LIB
+    #define WIN32_LEAN_AND_MEAN 
+    #include <windows.h>
+    #undef WIN32_LEAN_AND_MEAN 
+#endif
 
 #include <string>
 #include <utility>
+#include <map>
+#include <set>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <initializer_list>
+#include <optional>
+#include <string_view>
+#include <iterator>
+#include <functional>
+
+#ifdef LOGGER_USE_SOCKET
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <afunix.h>
+
+    #ifdef _MSC_VER
+        #pragma comment(lib, "Ws2_32.lib")
+    #endif
+#endif
+
+#ifdef LOGGER_COMPILED_LIB
+    #define LOGGER_INLINE
+#else
+    #define LOGGER_INLINE inline
+#endif
+
+// Logger library built as dll (LOGGER_SHARED_LIB), LOGGER_EXPORTS is defined only when building it.
+#if defined(LOGGER_COMPILED_LIB) && defined(LOGGER_SHARED_LIB) && defined(_WIN32)
+    #ifdef LOGGER_EXPORTS
+        #define LOGGER_API __declspec(dllexport)
+    #else
+        #define LOGGER_API __declspec(dllimport)
+    #endif
+#else
+    #define LOGGER_API
+#endif
+
+// Marks rarely called function, which is kept out of hot path of logging.
+#ifdef _MSC_VER
+    #define LOGGER_COLD __declspec(noinline)
+#else
+    #define LOGGER_COLD __attribute__((cold))
+#endif
 
 //------------------------------------------------------------------------------
 // Declaration
@@ -52,10 +111,643 @@ enum class LoggerOption {
     LOG_TRACE,
     LOG_DUMP,
     LOG_EVENT,
-    LOG_WARNING
+    LOG_WARNING,
+    SANITIZE_UTF8,
+    COLLECT_STATS
+};
+
+// Type of metric registered by Logger::RegisterMetric.
+//      COUNTER     - value is added to sum,
+//      GAUGE       - value replaces current one,
+//      HISTOGRAM   - value is sample of distribution.
+enum class LoggerMetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+// Compression of blocks in file opened by Logger::OpenCompressedFile.
+//      LZ      - built-in LZ77 compression (LZ4 block format),
+//      ZLIB    - deflate, available only when LOGGER_USE_ZLIB is defined and zlib is linked.
+enum class LoggerCompression {
+    LZ,
+    ZLIB
 };
 
-class Logger {
+// Declares category of log entries as type, which can be used in Logger::Log, Logger::Enable and Logger::Disable.
+// Prefix of entries "[<name>]: " is generated at compile time. Must be used at namespace or class scope.
+// type_name        Name of declared type.
+// name             Name of category, string literal. Encoding: ASCII or UTF8.
+// severity         Entries of category are logged only if severity is not lower than Logger::GetMinSeverity().
+//                  Severity of built-in categories: Trace 0, Dump 100, Event 200, Warning 300, Error 400, Fatal Error 500.
+#define LOGGER_CATEGORY(type_name, name, severity) \
+    struct type_name { \
+        static constexpr const char*    NAME        = name; \
+        static constexpr int            SEVERITY    = severity; \
+    }
+
+// Built-in categories.
+namespace LoggerCategory {
+    LOGGER_CATEGORY(Trace,      "Trace",        0);
+    LOGGER_CATEGORY(Dump,       "Dump",         100);
+    LOGGER_CATEGORY(Event,      "Event",        200);
+    LOGGER_CATEGORY(Warning,    "Warning",      300);
+    LOGGER_CATEGORY(Error,      "Error",        400);
+    LOGGER_CATEGORY(FatalError, "Fatal Error",  500);
+}
+
+class LoggerCategoryPrefixGenerator {
+public:
+    static constexpr size_t GetLength(const char* name) {
+        size_t length = 0;
+        while (name[length] != '\0') ++length;
+        return length + 4; // with "[", "]: "
+    }
+
+    template <size_t SIZE>
+    static constexpr std::array<char, SIZE> Generate(const char* name) {
+        std::array<char, SIZE> prefix = {};
+        size_t index = 0;
+
+        prefix[index++] = '[';
+        while (*name != '\0') prefix[index++] = *name++;
+        prefix[index++] = ']';
+        prefix[index++] = ':';
+        prefix[index++] = ' ';
+
+        return prefix;
+    }
+};
+
+// Prefix "[<name>]: " of entries of category, generated at compile time.
+template <typename CategoryType>
+struct LoggerCategoryPrefix {
+    static constexpr size_t                     LENGTH  = LoggerCategoryPrefixGenerator::GetLength(CategoryType::NAME);
+    static constexpr std::array<char, LENGTH + 1> TEXT  = LoggerCategoryPrefixGenerator::Generate<LENGTH + 1>(CategoryType::NAME);
+};
+
+struct LoggerCategoryStats {
+    uint64_t entry_count;
+    uint64_t byte_count;
+};
+
+// Non-owning reference to null-terminated string, passed as format to log functions.
+// Constructed implicitly from string literal or std::string, so call site doesn't construct std::string.
+class LoggerStringRef {
+public:
+    LoggerStringRef(const char* text) : m_text(text) {}
+    LoggerStringRef(const std::string& text) : m_text(text.c_str()) {}
+
+    const char* c_str() const { return m_text; }
+
+private:
+    const char* m_text;
+};
+
+// Part of text passed to LogSpans. Data doesn't need to be null-terminated.
+struct LoggerSpan {
+    const char* data;
+    size_t      length;
+};
+
+//------------------------------------------------------------------------------
+
+// Appends value of type, which can't be passed to printf, directly to text of entry. 
+// Such value is logged by any format specifier, for example '%s'. 
+// Own type is supported by specialization of LoggerFormatter:
+//      template <>
+//      struct LoggerFormatter<Point> {
+//          static void Append(std::string& text, const Point& point) { ... }
+//      };
+// or by function in namespace of the type (found by argument-dependent lookup):
+//      void LoggerAppend(std::string& text, const Point& point);
+// Built-in: std::string, std::string_view, containers (with begin and end), std::pair, std::optional, enums.
+template <typename Type, typename Enable = void>
+struct LoggerFormatter {
+    static void Append(std::string& text, const Type& value) {
+        LoggerAppend(text, value);
+    }
+};
+
+template <>
+struct LoggerFormatter<bool> {
+    static void Append(std::string& text, bool value) {
+        text += value ? "true" : "false";
+    }
+};
+
+template <>
+struct LoggerFormatter<char> {
+    static void Append(std::string& text, char value) {
+        text += value;
+    }
+};
+
+template <typename Type>
+struct LoggerFormatter<Type, typename std::enable_if<std::is_integral<Type>::value>::type> {
+    static void Append(std::string& text, Type value) {
+        char buffer[24];
+        char* end = buffer + sizeof(buffer);
+        char* begin = end;
+
+        // Digits are written from the end. Negative value is converted digit by digit, so minimal value doesn't overflow.
+        const bool is_negative = value < 0;
+        do {
+            const int digit = int(value % 10);
+            *--begin = char('0' + (is_negative ? -digit : digit));
+            value /= 10;
+        } while (value != 0);
+        if (is_negative) *--begin = '-';
+
+        text.append(begin, end - begin);
+    }
+};
+
+template <typename Type>
+struct LoggerFormatter<Type, typename std::enable_if<std::is_floating_point<Type>::value>::type> {
+    static void Append(std::string& text, Type value) {
+        char buffer[32];
+        const int count = snprintf(buffer, sizeof(buffer), "%g", double(value));
+        if (count > 0) text.append(buffer, (count < int(sizeof(buffer))) ? count : sizeof(buffer) - 1);
+    }
+};
+
+template <typename Type>
+struct LoggerFormatter<Type, typename std::enable_if<std::is_enum<Type>::value>::type> {
+    static void Append(std::string& text, Type value) {
+        using UnderlyingType = typename std::underlying_type<Type>::type;
+        // Enum of char type is logged as number, not as character.
+        using IntegerType = typename std::conditional<std::is_signed<UnderlyingType>::value, long long, unsigned long long>::type;
+        LoggerFormatter<IntegerType>::Append(text, IntegerType(value));
+    }
+};
+
+template <typename Type>
+struct LoggerFormatter<Type*> {
+    static void Append(std::string& text, const Type* value) {
+        if constexpr (std::is_same<typename std::remove_cv<Type>::type, char>::value) {
+            text += value ? value : "(null)";
+        } else {
+            char buffer[32];
+            const int count = snprintf(buffer, sizeof(buffer), "%p", static_cast<const void*>(value));
+            if (count > 0) text.append(buffer, (count < int(sizeof(buffer))) ? count : sizeof(buffer) - 1);
+        }
+    }
+};
+
+template <>
+struct LoggerFormatter<std::string> {
+    static void Append(std::string& text, const std::string& value) {
+        text += value;
+    }
+};
+
+template <>
+struct LoggerFormatter<std::string_view> {
+    static void Append(std::string& text, std::string_view value) {
+        text.append(value.data(), value.length());
+    }
+};
+
+template <typename FirstType, typename SecondType>
+struct LoggerFormatter<std::pair<FirstType, SecondType>> {
+    static void Append(std::string& text, const std::pair<FirstType, SecondType>& value) {
+        text += '(';
+        LoggerFormatter<typename std::decay<FirstType>::type>::Append(text, value.first);
+        text += ", ";
+        LoggerFormatter<typename std::decay<SecondType>::type>::Append(text, value.second);
+        text += ')';
+    }
+};
+
+template <typename Type>
+struct LoggerFormatter<std::optional<Type>> {
+    static void Append(std::string& text, const std::optional<Type>& value) {
+        if (value) {
+            LoggerFormatter<Type>::Append(text, *value);
+        } else {
+            text += "nullopt";
+        }
+    }
+};
+
+template <typename Type, typename Enable = void>
+struct LoggerIsContainer : std::false_type {};
+
+template <typename Type>
+struct LoggerIsContainer<Type, std::void_t<decltype(std::begin(std::declval<const Type&>())), decltype(std::end(std::declval<const Type&>()))>> : std::true_type {};
+
+// Containers: [element, element, ...]. Map is logged as list of pairs: [(key, value), ...].
+template <typename Type>
+struct LoggerFormatter<Type, typename std::enable_if<LoggerIsContainer<Type>::value>::type> {
+    static void Append(std::string& text, const Type& value) {
+        using ElementType = typename std::decay<decltype(*std::begin(value))>::type;
+
+        text += '[';
+        bool is_first = true;
+        for (const auto& element : value) {
+            if (!is_first) text += ", ";
+            is_first = false;
+            LoggerFormatter<ElementType>::Append(text, element);
+        }
+        text += ']';
+    }
+};
+
+// True, if type is function which produces message of log entry lazily, either:
+//      void (std::string& text)        appends message to text of entry,
+//      Type ()                         returns message (any type logged by '%s', for example std::string).
+template <typename Type, typename Enable = void>
+struct LoggerIsMessageFunction : std::false_type {};
+
+template <typename Type>
+struct LoggerIsMessageFunction<Type, typename std::enable_if<std::is_invocable<Type&, std::string&>::value>::type> : std::true_type {};
+
+template <typename Type>
+struct LoggerIsMessageFunction<Type, typename std::enable_if<!std::is_invocable<Type&, std::string&>::value && std::is_invocable<Type&>::value>::type> 
+    : std::integral_constant<bool, !std::is_void<typename std::invoke_result<Type&>::type>::value> {};
+
+// Statistics of logger itself. Collected only while LoggerOption::COLLECT_STATS is enabled.
+struct LoggerStats {
+    LoggerCategoryStats text;           // from LogText
+    LoggerCategoryStats trace;
+    LoggerCategoryStats dump;
+    LoggerCategoryStats event;
+    LoggerCategoryStats warning;
+    LoggerCategoryStats error;
+    LoggerCategoryStats fatal_error;
+    LoggerCategoryStats custom;         // from categories declared by LOGGER_CATEGORY
+
+    uint64_t suppressed_count;          // entries not logged, because their category is disabled
+    uint64_t shed_count;                // entries not logged, because budget of logger is exceeded (see Logger::SetBudget)
+    uint64_t dropped_count;             // entries lost by output
+
+    // Of output to which logger writes.
+    uint64_t flush_count;               // writes to file
+    uint64_t format_time_ns;            // time spent on generating entries
+    uint64_t write_time_ns;             // time spent on writing to file and to standard output
+    uint64_t max_batch_length;          // the biggest amount of bytes waiting in file batch
+};
+
+// Ring buffer in named shared memory, to which many processes write entries and from which one collector reads them.
+// Ring consists of slots of equal size. Entry occupies one or more consecutive slots, reserved by lock-free 
+// compare-and-swap on reserve position. Each slot is committed by storing its position in the ring as sequence, 
+// so collector can tell written slots from reserved ones. Slot which stays reserved, but not committed, longer than 
+// abandon timeout is treated as abandoned by crashed process, reclaimed and skipped. Writer claims slot by 
+// compare-and-swap from sequence left by previous lap of ring, and commits it by compare-and-swap from its claim, 
+// so writer which was only delayed neither commits reclaimed slot, nor touches slot reused by next lap. It drops its entry.
+class LOGGER_API LoggerSharedRing {
+public:
+    LoggerSharedRing();
+    virtual ~LoggerSharedRing();
+
+    // Creates shared memory. Returns false if shared memory can not be created or it already exists.
+    // name             Name of shared memory. Encoding: ASCII or UTF8.
+    // slot_count       Number of slots in ring.
+    // slot_size        Size of slot in bytes, with 16 bytes of slot header. Rounded up to multiple of 8.
+    bool Create(const std::string& name, size_t slot_count, size_t slot_size);
+
+    // Opens shared memory created by other process. Returns false if it doesn't exist.
+    bool Open(const std::string& name);
+
+    void Close();
+
+    bool IsOpened() const;
+
+    // Writes entry to ring. Returns false, if there is no free space in ring and entry is dropped.
+    // Same as Reserve followed by Commit.
+    bool Push(const char* text, size_t length);
+
+    // Reserves slots for entry of given length. Returns false, if there is no free space in ring and entry is dropped.
+    // position         Output. Position of first reserved slot, to be passed to Commit.
+    bool Reserve(size_t length, uint64_t& position);
+
+    // Writes entry to slots reserved by Reserve and commits them. Returns false if slots were reclaimed by reader 
+    // in the meantime and entry is dropped.
+    bool Commit(uint64_t position, const char* text, size_t length);
+
+    // Reads next entry from ring. Returns false if there is no committed entry to read.
+    // Only one reader at a time is allowed.
+    bool Pop(std::string& text, unsigned abandon_timeout_ms);
+
+    uint64_t GetDroppedCount() const;
+    uint64_t GetAbandonedCount() const;
+
+private:
+    enum { 
+        MAGIC               = 0x474F4C53, // "SLOG"
+        HEADER_SIZE         = 64,
+        SLOT_HEADER_SIZE    = 16
+    };
+
+    struct Header {
+        uint32_t                magic;
+        uint32_t                slot_size;
+        uint64_t                slot_count;
+        std::atomic<uint64_t>   reserve_position;
+        std::atomic<uint64_t>   read_position;
+        std::atomic<uint64_t>   dropped_count;
+        std::atomic<uint64_t>   abandoned_count;
+    };
+
+    struct SlotHeader {
+        std::atomic<uint64_t>   sequence;       // position + 1 of committed slot, see ToWritingSequence and ToReclaimedSequence
+        uint32_t                slot_count;     // number of slots of entry in first slot, 0 in next slots
+        uint32_t                length;         // length of text in slot
+    };
+
+    bool Map(void* mapping);
+    SlotHeader* GetSlot(uint64_t position) const;
+
+    // Returns sequence of slot reclaimed by reader or released by writer: position + 1 with the highest bit set.
+    static uint64_t ToReclaimedSequence(uint64_t position);
+
+    // Returns sequence of slot claimed by writer, which writes to it: position + 1 with the second highest bit set.
+    static uint64_t ToWritingSequence(uint64_t position);
+
+    // Returns true if sequence is left by previous lap of ring in slot, which is free for writer of given position:
+    // 0 at first lap, otherwise committed or reclaimed sequence of position one lap back.
+    bool IsFreeSequence(uint64_t sequence, uint64_t position) const;
+
+    static bool ToUTF16(const std::string& text_utf8, std::wstring& text_utf16);
+
+    void*       m_mapping;
+    Header*     m_header;
+    char*       m_slots;
+
+    // Used by reader.
+    uint64_t                                m_stalled_position;
+    std::chrono::steady_clock::time_point   m_stall_begin;
+};
+
+#ifdef LOGGER_USE_SOCKET
+
+// Type of socket used by LoggerSocketSink.
+//      UDP     - datagram socket, address: "host:port",
+//      TCP     - stream socket, address: "host:port",
+//      UNIX    - unix domain stream socket (on Windows since Windows 10 1803), address: path of socket file.
+enum class LoggerSocketType {
+    UDP,
+    TCP,
+    UNIX
+};
+
+// Format of entries sent by LoggerSocketSink.
+//      SYSLOG          - RFC 5424 message: "<PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID - - MSG", with facility 'user',
+//                        one message per datagram or preceded by its length and space in stream (RFC 6587),
+//      LENGTH_PREFIXED - text of entry preceded by its length as 4 byte little-endian integer, 
+//                        many entries per datagram.
+enum class LoggerSocketFraming {
+    SYSLOG,
+    LENGTH_PREFIXED
+};
+
+// Sends entries to local collector through socket. Entries are framed and collected in bounded buffer by logging threads, 
+// and sent in batches by background thread, so logging never waits for socket. When buffer is full, because collector 
+// is slow or down, entries are dropped and counted. Stream socket is connected by background thread and reconnected 
+// after connection is lost.
+class LOGGER_API LoggerSocketSink {
+public:
+    LoggerSocketSink();
+    virtual ~LoggerSocketSink();
+
+    // Returns false if address can not be resolved or socket can not be created.
+    // address          "host:port" (or "[host]:port" for IPv6) for UDP and TCP, path of socket file for UNIX. 
+    //                  Encoding: ASCII or UTF8.
+    // buffer_size      Maximal amount of bytes of framed entries waiting to be sent.
+    // app_name         APP-NAME of syslog messages. If empty then "-".
+    bool Open(LoggerSocketType type, const std::string& address, LoggerSocketFraming framing, size_t buffer_size, const std::string& app_name);
+
+    // Sends entries waiting in buffer and closes socket. Entries which can not be sent within 1 second are dropped.
+    void Close();
+
+    bool IsOpened() const;
+
+    // Frames entry and adds it to buffer. Returns false if buffer is full and entry is dropped.
+    // severity         Severity of category of entry (see LOGGER_CATEGORY), mapped to syslog severity.
+    bool Push(const char* text, size_t length, int severity);
+
+    // Wakes background thread to send entries waiting in buffer.
+    void Flush();
+
+    uint64_t GetSentCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    enum { 
+        MAX_DATAGRAM_SIZE       = 65507,
+        SEND_INTERVAL_MS        = 10,
+        WAIT_INTERVAL_MS        = 100,
+        CONNECT_TIMEOUT_MS      = 1000,
+        RECONNECT_INTERVAL_MS   = 1000,
+        CLOSE_TIMEOUT_MS        = 1000
+    };
+
+    static int ToSyslogSeverity(int severity);
+
+    void Send();
+    bool Connect();
+    void SendBatch();
+    bool SendAll(const char* data, size_t length, size_t& sent_length);
+    bool WaitForWritable(SOCKET socket_handle, unsigned timeout_ms);
+    bool IsCloseTimeoutReached() const;
+
+    bool                                    m_is_opened;
+    bool                                    m_is_wsa_started;
+    LoggerSocketType                        m_type;
+    LoggerSocketFraming                     m_framing;
+    size_t                                  m_buffer_size;
+    std::string                             m_syslog_header;    // "HOSTNAME APP-NAME PROCID - - "
+
+    sockaddr_storage                        m_address;
+    int                                     m_address_length;
+    SOCKET                                  m_socket;
+    std::chrono::steady_clock::time_point   m_next_connect_time;
+
+    std::thread                             m_thread;
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_condition;
+    std::string                             m_buffer;
+    std::vector<size_t>                     m_buffer_ends;      // end of each entry in buffer
+    bool                                    m_is_flush_requested;
+    std::atomic<bool>                       m_is_stop;
+    std::chrono::steady_clock::time_point   m_close_deadline;
+
+    // Used by background thread.
+    std::string                             m_batch;
+    std::vector<size_t>                     m_batch_ends;
+
+    std::atomic<uint64_t>                   m_sent_count;
+    std::atomic<uint64_t>                   m_dropped_count;
+};
+
+#endif // LOGGER_USE_SOCKET
+
+//------------------------------------------------------------------------------
+
+// Writes entries to standard output from background thread, so slow console or stalled pipe doesn't block logging thread.
+// Entries are collected in bounded buffer and background thread writes all waiting entries in one call.
+class LOGGER_API LoggerConsoleSink {
+public:
+    LoggerConsoleSink();
+    virtual ~LoggerConsoleSink();
+
+    // buffer_size      Maximal amount of bytes of entries waiting to be written.
+    // is_colored       If true then entries are colored by severity with ANSI escape sequences, by background thread.
+    void Open(size_t buffer_size, bool is_colored);
+
+    // Writes entries waiting in buffer and stops background thread.
+    void Close();
+
+    bool IsOpened() const;
+
+    // Adds entry to buffer. Returns false if buffer is full and entry is dropped.
+    // severity         Severity of category of entry (see LOGGER_CATEGORY), used for coloring.
+    bool Push(const char* text, size_t length, int severity);
+
+    // Wakes background thread to write entries waiting in buffer.
+    void Flush();
+
+    uint64_t GetWrittenCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    enum { 
+        WRITE_INTERVAL_MS = 10 
+    };
+
+    struct EntryEnd {
+        size_t  end;            // end of entry in buffer
+        int     severity;
+    };
+
+    // Returns ANSI escape sequence of color of entry, or empty string for default color.
+    static const char* GetColor(int severity);
+
+    void Write();
+    void WriteBatch();
+
+    std::atomic<bool>                       m_is_opened;    // read without lock by logging threads
+    bool                                    m_is_colored;
+    size_t                                  m_buffer_size;
+
+    std::thread                             m_thread;
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_condition;
+    std::string                             m_buffer;
+    std::vector<EntryEnd>                   m_buffer_ends;
+    bool                                    m_is_flush_requested;
+    bool                                    m_is_stop;
+
+    // Used by background thread.
+    std::string                             m_batch;
+    std::vector<EntryEnd>                   m_batch_ends;
+    std::string                             m_colored_batch;
+
+    std::atomic<uint64_t>                   m_written_count;
+    std::atomic<uint64_t>                   m_dropped_count;
+};
+
+// Span of entries in log file, described by record of sidecar index (see Logger::OpenIndexedFile).
+struct LoggerIndexSpan {
+    uint64_t offset;                // of first entry of span in log file
+    uint64_t length;                // in bytes, set by LoggerIndexedFileReader
+    int64_t  begin_time_ns;         // time of logging first entry, in nanoseconds since epoch
+    int64_t  end_time_ns;           // time of logging last entry, in nanoseconds since epoch
+    uint32_t entry_count;
+
+    // Entries counted by severity of their category, in ranges of built-in categories (see LOGGER_CATEGORY).
+    uint32_t trace_count;
+    uint32_t dump_count;
+    uint32_t event_count;           // with text from LogText
+    uint32_t warning_count;
+    uint32_t error_count;
+    uint32_t fatal_error_count;
+};
+
+// Format of sidecar index "<log file name>.idx":
+//      header: "LGIX", version, record size, reserved (uint32 each)
+//      record: offset, begin time, end time (int64 each), entry count, counts of trace, dump, event, warning, error 
+//              and fatal error entries, reserved (uint32 each)
+// All numbers are little-endian.
+class LOGGER_API LoggerFileIndex {
+public:
+    enum { 
+        HEADER_SIZE     = 16,
+        RECORD_SIZE     = 56,
+        VERSION         = 1
+    };
+
+    static std::string GetIndexFileName(const std::string& file_name);
+
+    static void EncodeHeader(unsigned char* data);
+
+    // Returns false if header is not valid.
+    static bool DecodeHeader(const unsigned char* data);
+
+    static void EncodeRecord(unsigned char* data, const LoggerIndexSpan& span);
+    static void DecodeRecord(const unsigned char* data, LoggerIndexSpan& span);
+
+    // Counts entry in span by severity of its category.
+    static void CountEntry(LoggerIndexSpan& span, int severity);
+
+private:
+    static void WriteUInt32(unsigned char* data, uint32_t value);
+    static void WriteUInt64(unsigned char* data, uint64_t value);
+    static uint32_t ReadUInt32(const unsigned char* data);
+    static uint64_t ReadUInt64(const unsigned char* data);
+};
+
+// Descriptor of call site of logging macro (LOGGER_TRACE, LOGGER_TRACK), stored in static variable at call site.
+// Descriptor is registered at first use of call site, then it can be enabled or disabled by Logger::EnableCallSites 
+// and Logger::DisableCallSites. Checking whether registered call site is enabled costs one byte load.
+class LOGGER_API LoggerCallSite {
+public:
+    constexpr LoggerCallSite(const char* file, int line, const char* function_name, const char* category_name) : 
+        m_file(file), 
+        m_line(line), 
+        m_function_name(function_name), 
+        m_category_name(category_name), 
+        m_state(STATE_UNREGISTERED), 
+        m_next(nullptr) {}
+
+    LoggerCallSite(const LoggerCallSite&) = delete;
+    LoggerCallSite& operator=(const LoggerCallSite&) = delete;
+
+    // Registers call site at first call.
+    bool IsEnabled() const;
+
+    const char* GetFile() const;
+    int GetLine() const;
+    const char* GetFunctionName() const;
+    const char* GetCategoryName() const;
+
+private:
+    friend class Logger;
+
+    enum : uint8_t {
+        STATE_UNREGISTERED,
+        STATE_ENABLED,
+        STATE_DISABLED
+    };
+
+    bool Register() const;
+
+    // Returns true if function name, category name, file or "<file>:<line>" matches pattern.
+    bool IsMatching(const char* pattern) const;
+
+    const char*                     m_file;
+    int                             m_line;
+    const char*                     m_function_name;
+    const char*                     m_category_name;
+    mutable std::atomic<uint8_t>    m_state;
+    mutable const LoggerCallSite*   m_next;     // next registered call site
+};
+
+class LoggerRegistry;
+class LoggerSocketSink;
+
+class LOGGER_API Logger {
 public:
     typedef void (*DoAtFatalErrorFnP_T)(const char* message);
 
@@ -73,6 +765,91 @@ public:
 
     bool IsFileOpened() const;
 
+    // Opens or creates a log file to which logged text is written as independently compressed blocks.
+    // Blocks are compressed and written by background thread. Each block can be read and decompressed 
+    // separately by LoggerCompressedFileReader.
+    // file_name            Name of log file. Encoding: ACII or UTF8.
+    // is_append            If true then blocks are added after current content of file.
+    //                      If false then current content of file is removed.
+    // block_size           Size of text in one block, also used as file batch size. 
+    //                      Block is also written at Flush and after logging error or fatal error, 
+    //                      which wait until all queued blocks are written.
+    // At most 16 blocks wait for compression. When there are more, logging thread waits.
+    void OpenCompressedFile(const std::string& file_name, bool is_append, LoggerCompression compression = LoggerCompression::LZ, size_t block_size = 65536);
+
+    bool IsCompressedFileOpened() const;
+
+    // Opens or creates a log file, along with sidecar index "<file_name>.idx" written as entries are logged.
+    // Index has record for each span of entries with its offset in file, time of its first and last entry 
+    // and counts of its entries per severity. Span ends after 'entry_interval' entries or with first entry logged 
+    // 'time_interval_ms' after its beginning. Index is used by LoggerIndexedFileReader to find entries logged in time range.
+    // Time of entry is taken from its time prefix (LoggerOption::LOG_TIME). Without time prefix, clock is read 
+    // only at each 64-th entry of span, so span can end up to 63 entries after its time interval. 
+    // Times in index never decrease, even if system clock is set back.
+    // file_name            Name of log file. Encoding: ACII or UTF8.
+    // is_append            If true then current content of file and index is keept.
+    //                      If false then current content of file and index is removed.
+    void OpenIndexedFile(const std::string& file_name, bool is_append, size_t entry_interval = 1024, unsigned time_interval_ms = 1000);
+
+    bool IsIndexedFileOpened() const;
+
+    // Opens shared memory ring created by LoggerCollector (possibly in other process).
+    // Each logged text is written to the ring as one entry and collector writes it to its logger.
+    // When ring is full, text is dropped (counted in LoggerStats::dropped_count).
+    // name                 Name of shared memory. Encoding: ASCII or UTF8.
+    void OpenSharedMemory(const std::string& name);
+    void CloseSharedMemory();
+    bool IsSharedMemoryOpened() const;
+
+#ifdef LOGGER_USE_SOCKET
+    // Opens socket through which each logged entry is sent to local collector, see LoggerSocketSink.
+    // Entries are sent in batches by background thread. When buffer is full, entry is dropped 
+    // (counted in LoggerStats::dropped_count). Flush wakes background thread to send entries immediately.
+    // address              "host:port" for UDP and TCP, path of socket file for UNIX. Encoding: ASCII or UTF8.
+    // buffer_size          Maximal amount of bytes of entries waiting to be sent.
+    // app_name             APP-NAME of syslog messages.
+    void OpenSocket(LoggerSocketType type, const std::string& address, LoggerSocketFraming framing, size_t buffer_size = 1024 * 1024, const std::string& app_name = "");
+    void CloseSocket();
+    bool IsSocketOpened() const;
+
+    // Returns number of entries sent through socket and number of entries dropped by socket sink, 
+    // including ones lost at sending.
+    uint64_t GetSocketSentCount() const;
+    uint64_t GetSocketDroppedCount() const;
+#endif
+
+    // Opens sharded log files. Each thread, which logs through this logger, writes to its own file:
+    // "<file_name_prefix>.<thread id>.<shard number>.shard", without locking. Each entry in shard is preceded by record header:
+    //      <sequence> <timestamp> <thread name> <length>\n
+    // where sequence is global for logger and timestamp is in nanoseconds since epoch.
+    // Shards can be merged into one log file by MergeShardFiles. Shards are closed by CloseFile.
+    // No thread may log while shards are being closed.
+    // file_name_prefix     Encoding: ASCII or UTF8.
+    void OpenShardedFiles(const std::string& file_name_prefix);
+    bool IsShardedFilesOpened() const;
+
+    // Returns names of shard files created since last OpenShardedFiles.
+    std::vector<std::string> GetShardFileNames();
+
+    // Sets name of calling thread, used in shard record headers instead of thread id.
+    // Spaces in name are replaced with '_'. Name is cut to 100 characters.
+    static void SetThreadName(const std::string& name);
+
+    // Merges shard files into one log file, ordered by sequence of entries.
+    // is_tagged            If true then each entry is prefixed with its timestamp and thread name:
+    //                      "[2023/01/25 11:54:35.123456][thread name]".
+    // Returns false if any file can not be opened or read.
+    static bool MergeShardFiles(const std::vector<std::string>& shard_file_names, const std::string& output_file_name, bool is_tagged);
+
+    // Sets size of buffer in which text logged to file is collected, before it's written to the file in one call.
+    // Buffer is also written at closing file, at calling Flush and after logging error or fatal error.
+    // batch_size           If 0 then each logged text is written to the file immediately (default).
+    void SetFileBatchSize(size_t batch_size);
+    size_t GetFileBatchSize() const;
+
+    // Writes text collected in buffer to log file.
+    void Flush();
+
     // Enables redirecting log messages to standard output.
     void OpenStdOut();
 
@@ -81,18 +858,113 @@ public:
 
     bool IsStdOutOpened() const;
 
+    // Enables writing log messages to standard output by background thread, see LoggerConsoleSink. 
+    // Unlike OpenStdOut, logging thread only copies entry to buffer, so slow console doesn't delay it nor other outputs. 
+    // When buffer is full, entry is dropped (counted in LoggerStats::dropped_count).
+    // buffer_size          Maximal amount of bytes of entries waiting to be written.
+    // is_colored           If true then entries are colored by severity (ANSI escape sequences).
+    void OpenAsyncStdOut(size_t buffer_size = 1024 * 1024, bool is_colored = false);
+    void CloseAsyncStdOut();
+    bool IsAsyncStdOutOpened() const;
+
+    // Returns number of entries dropped by asynchronous standard output.
+    uint64_t GetAsyncStdOutDroppedCount() const;
+
     void SetDoAtFatalError(DoAtFatalErrorFnP_T do_at_fatal_error);
 
     // Enables/Disables:
-    //      LOG_TIME    - logging with timestamps (default: Disabled),
-    //      LOG_TRACE   - logging trace (default: Enabled),
-    //      LOG_DUMP    - logging dump (default: Enabled),
-    //      LOG_EVENT   - logging event (default: Enabled),
-    //      LOG_WARNING - logging warning (default: Enabled).
+    //      LOG_TIME        - logging with timestamps (default: Disabled),
+    //      LOG_TRACE       - logging trace (default: Enabled),
+    //      LOG_DUMP        - logging dump (default: Enabled),
+    //      LOG_EVENT       - logging event (default: Enabled),
+    //      LOG_WARNING     - logging warning (default: Enabled),
+    //      SANITIZE_UTF8   - replacing invalid utf-8 sequences in logged text with U+FFFD (default: Disabled),
+    //      COLLECT_STATS   - collecting statistics of logger, see GetStats (default: Disabled).
     void Enable(LoggerOption option);
     void Disable(LoggerOption option);
     void SetOption(LoggerOption option, bool is);
 
+    // Enables/Disables logging entries of category, built-in from LoggerCategory or declared by LOGGER_CATEGORY 
+    // (default: Enabled). For built-in categories, same as Enable/Disable of corresponding LoggerOption.
+    // Error and fatal error can not be disabled. Only first 64 declared categories can be disabled, 
+    // entries of other ones are filtered only by severity.
+    template <typename CategoryType>
+    void Enable();
+    template <typename CategoryType>
+    void Disable();
+    template <typename CategoryType>
+    bool IsEnabled() const;
+
+    // Entries of categories with severity lower than min_severity are not logged (default: 0).
+    // Error and fatal error are always logged.
+    void SetMinSeverity(int min_severity);
+    int GetMinSeverity() const;
+
+    // Name of logger from LoggerRegistry. Empty for standalone logger.
+    const std::string& GetName() const;
+
+    // Returns statistics collected while LoggerOption::COLLECT_STATS was enabled.
+    LoggerStats GetStats() const;
+    void ResetStats();
+
+    // Sets how often summary of statistics is logged as "[Stats]: ..." entry (checked at logging entries).
+    // interval_ms          If 0 then summary is not logged (default).
+    void SetStatsInterval(unsigned interval_ms);
+
+    // Registers metric, or finds already registered metric of same name. Returns index of metric.
+    // name                 Encoding: ASCII or UTF8.
+    size_t RegisterMetric(const std::string& name, LoggerMetricType type);
+
+    // Records value of metric in accumulator of calling thread, without locking. 
+    // metric_index         Index returned by RegisterMetric.
+    void RecordMetric(size_t metric_index, int64_t value);
+
+    // Sets how often background thread logs one aggregated entry per metric, from values recorded since previous one:
+    //      [Metric]: requests (counter): count 3, sum 6.
+    //      [Metric]: queue_depth (gauge): count 3, last 4, min 1, max 9.
+    //      [Metric]: latency_us (histogram): count 3, sum 60, min 10, max 30, p50 20, p90 30, p99 30.
+    // Metrics without recorded values are skipped. Percentiles are approximated with error up to 1/16 of value, 
+    // negative samples are counted as 0 in percentiles. 
+    // interval_ms          If 0 then background thread is stopped (default).
+    void SetMetricInterval(unsigned interval_ms);
+
+    // Logs aggregated entries of metrics immediately.
+    void FlushMetrics();
+
+    // Registers provider of state dump (cache sizes, connection tables), called by background thread of logger every interval, 
+    // instead of by worker threads. Providers which are due at the same time are called one after another 
+    // and their entries are output in one batch:
+    //      [Dump]: <name>: <text appended by provider>
+    // Providers aren't called at all while LOG_DUMP is disabled. 
+    // Provider must not register or unregister providers.
+    // name                 Encoding: ASCII or UTF8.
+    // interval_ms          How often provider is called, at least 1.
+    // provider             Appends dump to text of entry.
+    // Returns id of provider, used by UnregisterDumpProvider.
+    size_t RegisterDumpProvider(const std::string& name, unsigned interval_ms, std::function<void (std::string& text)> provider);
+
+    // After return, provider isn't called anymore.
+    void UnregisterDumpProvider(size_t provider_id);
+
+    // Calls all providers immediately.
+    void FlushDumpProviders();
+
+    // Sets maximal amount of bytes dumped by LogHexDump (default: 65536).
+    void SetHexDumpLimit(size_t limit);
+    size_t GetHexDumpLimit() const;
+
+    // Sets budget of logger. When budget is used above given part, entries of categories with lower severity are shed:
+    //      50%     - trace,
+    //      75%     - trace and dump,
+    //      100%    - all entries with severity lower than warning (see LOGGER_CATEGORY).
+    // Warnings, errors, fatal errors and text from LogText are never shed. After each second in which entries were shed, 
+    // summary is logged with next entry or at closing file:
+    //      [Budget]: Shed entries: trace 1000, dump 200, event 34.
+    // Loggers from LoggerRegistry share budget of root logger.
+    // bytes_per_second     Bytes of entries logged within one second. If 0 then budget is disabled (default).
+    // memory_bytes         Bytes of text waiting for compression (see OpenCompressedFile). If 0 then not limited (default).
+    void SetBudget(size_t bytes_per_second, size_t memory_bytes = 0);
+
     // for all Log{...}() methods:
     // Expected string encoding: ASCII or UTF8.
     // format           The format of a log message, same rules as in standard 'printf' function.
@@ -102,39 +974,154 @@ public:
     void LogText(const std::string& text);
 
     template <typename... Types>
-    void LogText(const std::string& format, Types&&... arguments);
+    void LogText(LoggerStringRef format, Types&&... arguments);
+
+    // Logs already formatted text of given length, same as LogText(text), but text isn't copied and isn't parsed as format.
+    // Meant for large payloads (serialized json, protocol dumps), which are already in caller's buffer.
+    void LogBuffer(const char* text, size_t length);
+
+    // Logs spans as one entry, in given order. Spans are written to outputs one after another (scatter-gather), 
+    // without joining them into one buffer. Example:
+    //      logger.LogSpans({{header, header_length}, {body, body_length}, {"\n", 1}});
+    void LogSpans(const LoggerSpan* spans, size_t span_count);
+    void LogSpans(std::initializer_list<LoggerSpan> spans);
+
+    // Logs entry of category declared by LOGGER_CATEGORY or built-in from LoggerCategory:
+    //      [<name>]: message
+    // Unlike LogError, logging entry of LoggerCategory::Error doesn't flush.
+    template <typename CategoryType, typename... Types>
+    void Log(LoggerStringRef format, Types&&... arguments);
+
+    // Logs entry of which message is produced by function (see LoggerIsMessageFunction). 
+    // Function is called only if entry passes all filters (category, severity, budget), 
+    // so expensive message (serialized state) costs nothing, when category is disabled. Example:
+    //      logger.LogDump([&](std::string& text) { state.AppendTo(text); });
+    template <typename CategoryType, typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type = 0>
+    void Log(FunctionType&& function);
 
     // Traces execution of function.
     template <typename... Types>
-    void LogTrace(const std::string& function_name, const std::string& format, Types&&... arguments);
+    void LogTrace(LoggerStringRef function_name, LoggerStringRef format, Types&&... arguments);
+
+    template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type = 0>
+    void LogTrace(LoggerStringRef function_name, FunctionType&& function);
 
     template <typename... Types>
-    void LogDump(const std::string& format, Types&&... arguments);
+    void LogDump(LoggerStringRef format, Types&&... arguments);
+
+    template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type = 0>
+    void LogDump(FunctionType&& function);
+
+    // Logs dump of binary data as lines of offset, hexadecimal bytes and ascii characters, preceded by message:
+    //      [Dump]: message
+    //      00000000  48 65 6C 6C 6F 20 57 6F  72 6C 64 0A 00 01 02 03  |Hello World.....|
+    // data             Pointer to dumped data.
+    // size             Size of dumped data in bytes. Only first GetHexDumpLimit() bytes are dumped.
+    template <typename... Types>
+    void LogHexDump(const void* data, size_t size, LoggerStringRef format, Types&&... arguments);
 
     template <typename... Types>
-    void LogEvent(const std::string& format, Types&&... arguments);
+    void LogEvent(LoggerStringRef format, Types&&... arguments);
+
+    template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type = 0>
+    void LogEvent(FunctionType&& function);
 
     template <typename... Types>
-    void LogWarning(const std::string& format, Types&&... arguments);
+    void LogWarning(LoggerStringRef format, Types&&... arguments);
+
+    template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type = 0>
+    void LogWarning(FunctionType&& function);
 
     template <typename... Types>
-    void LogError(const std::string& format, Types&&... arguments);
+    void LogError(LoggerStringRef format, Types&&... arguments);
 
     // Will exit from program after logging fatal error message.
     template <typename... Types>
-    void LogFatalError(const std::string& format, Types&&... arguments);
+    void LogFatalError(LoggerStringRef format, Types&&... arguments);
+
+    // Opens file of utf-8 name, same as _wfopen_s. Returns nullptr at failure.
+    static FILE* OpenFileUTF8(const std::string& file_name, const wchar_t* mode);
+
+    // Returns position of first byte of first invalid utf-8 sequence in text or 'size' if whole text is valid utf-8.
+    static size_t FindInvalidUTF8(const char* text, size_t size);
+
+    static bool IsValidUTF8(const std::string& text);
+
+    // Replaces each maximal invalid utf-8 subpart in text with replacement character U+FFFD.
+    // Text which is already valid is left untouched.
+    static void SanitizeUTF8(std::string& text);
+
+    // Node of thread-local stack of scopes tracked by LOGGER_TRACK and LOGGER_TRACK_SLOW.
+    struct TrackedScope {
+        const char*     function_name;
+        TrackedScope*   parent;
+    };
 
     // Tracks entering and exiting from scope: '{', '}'. 
     // To do so, macro LOGGER_TRACK must be called on beginning of the scope.
     class Tracker {
     public:
-        Tracker(Logger& logger, const char* function_name);
+        // call_site            Call site of LOGGER_TRACK. If it's disabled, then nothing is logged.
+        Tracker(Logger& logger, const char* function_name, const LoggerCallSite* call_site = nullptr);
         virtual ~Tracker();
     private:
         Logger& m_logger;
-        const char* m_function_name;
+        TrackedScope m_scope;
+        bool m_is_enabled;
+    };
+
+    // Logs one entry at exit from scope, only if scope took longer than threshold:
+    //      [Slow Scope]: Foo took 12.345 ms (threshold 10.000 ms), path: Main > Bar > Foo.
+    // Path contains enclosing scopes tracked by LOGGER_TRACK or LOGGER_TRACK_SLOW in calling thread.
+    // Otherwise, costs two reads of clock. Used by macro LOGGER_TRACK_SLOW.
+    class SlowTracker {
+    public:
+        SlowTracker(Logger& logger, const char* function_name, std::chrono::steady_clock::duration threshold);
+        virtual ~SlowTracker();
+    private:
+        Logger& m_logger;
+        TrackedScope m_scope;
+        std::chrono::steady_clock::duration m_threshold;
+        std::chrono::steady_clock::time_point m_begin;
+    };
+
+    // Adds key-value pair to context of calling thread, for lifetime of object.
+    // Context is rendered once at adding and removing pair, as "[key=value]" for each pair in order of adding, 
+    // and copied to each entry logged by calling thread, after category:
+    //      [Event][request=42][session=7]: message
+    // Object must be destroyed by thread which created it, in reverse order of creation (as local variable).
+    // key, value           Encoding: ASCII or UTF8.
+    class Context {
+    public:
+        Context(const std::string& key, const std::string& value);
+        virtual ~Context();
+
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+    private:
+        size_t m_previous_length;
     };
+
+    // Returns rendered context of calling thread. Empty if thread has no context.
+    static const std::string& GetContext();
+
+    // Enables or disables call sites of logging macros (LOGGER_TRACE, LOGGER_TRACK) which match pattern, 
+    // also call sites registered later. Call site matches pattern if its function name, category name, file or 
+    // "<file>:<line>" matches it. Wildcards: '*' - any sequence of characters, '?' - any character.
+    // Call sites are enabled by default. Later call overrides earlier ones for call sites matching both patterns.
+    // Entry from enabled call site is still filtered by its category (e.g. LoggerOption::LOG_TRACE).
+    static void EnableCallSites(const std::string& pattern);
+    static void DisableCallSites(const std::string& pattern);
+
+    // Returns call sites registered so far, which are call sites used at least once.
+    static std::vector<const LoggerCallSite*> GetCallSites();
+
+    // Returns true if whole text matches pattern. Wildcards: '*' - any sequence of characters, '?' - any character.
+    static bool IsMatchingPattern(const char* text, const char* pattern);
 private:
+    friend class LoggerRegistry;
+    friend class LoggerCallSite;
+
     class UTF8_Guardian {
     public:
         UTF8_Guardian() {
@@ -148,19 +1135,287 @@ private:
         std::string backup;
     };
 
+    enum StatsIndex {
+        STATS_TEXT,
+        STATS_TRACE,
+        STATS_DUMP,
+        STATS_EVENT,
+        STATS_WARNING,
+        STATS_ERROR,
+        STATS_FATAL_ERROR,
+        STATS_CUSTOM,
+
+        STATS_COUNT
+    };
+
+    struct AtomicCategoryStats {
+        std::atomic<uint64_t> entry_count;
+        std::atomic<uint64_t> byte_count;
+    };
+
+    LOGGER_CATEGORY(Stats, "Stats", LoggerCategory::Event::SEVERITY);
+    LOGGER_CATEGORY(Budget, "Budget", LoggerCategory::Warning::SEVERITY);
+
+    enum ShedIndex {
+        SHED_TRACE,
+        SHED_DUMP,
+        SHED_EVENT,
+
+        SHED_COUNT
+    };
+
+    // Returns true if entry of severity is shed because budget is exceeded.
+    bool IsShed(int severity);
+    bool IsShedByBudget(Logger& output, int severity);
+
+    // Starts new budget window when current one has ended, logging summary of previous one.
+    void UpdateBudgetWindow();
+    LOGGER_COLD void LogBudgetSummary();
+
+    struct DumpProvider {
+        size_t                                  id;
+        std::string                             name;
+        std::chrono::milliseconds               interval;
+        std::function<void (std::string&)>      function;
+        std::chrono::steady_clock::time_point   next_time;
+    };
+
+    void RunDumpProviders();
+    void StopDumpProviders();
+
+    // Calls providers which are due at time 'now' (or all) and outputs their entries in one batch. 
+    // Called with locked m_dump_provider_mutex.
+    void LogDumpProviders(bool is_all, std::chrono::steady_clock::time_point now);
+
+    LOGGER_CATEGORY(Metrics, "Metric", LoggerCategory::Event::SEVERITY);
+
+    enum {
+        METRIC_EXACT_BUCKET_COUNT   = 8,                                // values from 0 to 7 have own buckets
+        METRIC_BUCKET_COUNT         = METRIC_EXACT_BUCKET_COUNT + 60 * 8  // 8 buckets for each power of two up to 2^62
+    };
+
+    struct Metric;
+
+    // Values recorded by one thread. Written only by that thread, read by FlushMetrics.
+    struct MetricAccumulator {
+        Metric*                                     metric;
+        std::atomic<uint64_t>                       count;
+        std::atomic<int64_t>                        sum;
+        std::atomic<int64_t>                        min;        // reset by FlushMetrics
+        std::atomic<int64_t>                        max;        // reset by FlushMetrics
+        std::unique_ptr<std::atomic<uint64_t>[]>    buckets;    // only for histogram
+
+        // Values at previous FlushMetrics.
+        uint64_t                                    flushed_count;
+        int64_t                                     flushed_sum;
+        std::unique_ptr<uint64_t[]>                 flushed_buckets;
+    };
+
+    struct Metric {
+        std::string                                     name;
+        LoggerMetricType                                type;
+        std::atomic<int64_t>                            last;   // last value of gauge
+        std::vector<std::unique_ptr<MetricAccumulator>> accumulators;
+        MetricAccumulator*                              exited_accumulator;     // values of exited threads, not flushed yet
+    };
+
+    struct ThreadMetrics {
+        uint64_t                            session_id;     // of logger
+        std::vector<MetricAccumulator*>     accumulators;   // at index of metric
+    };
+
+    // Accumulators of calling thread. At thread exit, they are folded into metrics of loggers, which still exist.
+    struct ThreadMetricsList {
+        std::vector<ThreadMetrics>          elements;
+
+        ~ThreadMetricsList();
+    };
+
+    // Loggers by their metric session id, guarded by mutex.
+    struct MetricSessions {
+        std::mutex                          mutex;
+        std::map<uint64_t, Logger*>         loggers;
+    };
+
+    MetricAccumulator& GetThreadMetricAccumulator(size_t metric_index);
+    void FoldThreadMetrics(ThreadMetrics& thread_metrics);
+    void TickMetrics();
+    void StopMetricTick();
+
+    static MetricAccumulator& AddMetricAccumulator(Metric& metric);
+    static std::vector<ThreadMetrics>& GetThreadMetricsRef();
+    static MetricSessions& GetMetricSessionsRef();
+    static size_t GetMetricBucketIndex(int64_t value);
+    static int64_t GetMetricBucketValue(size_t bucket_index);   // middle of bucket
+    static int64_t GetMetricPercentile(const std::vector<uint64_t>& buckets, uint64_t sample_count, unsigned percent, int64_t min, int64_t max);
+
+    template <typename CategoryType>
+    static constexpr StatsIndex GetStatsIndex();
+
+    // Returns index of category declared by LOGGER_CATEGORY, assigned at first call.
+    template <typename CategoryType>
+    static size_t GetCategoryIndex();
+    static std::atomic<size_t>& GetCategoryCountRef();
+
+    template <typename CategoryType>
+    void SetCategory(bool is);
+
+    // Formats and outputs entry. Defined out of line, so call site of log function only checks whether entry is logged.
+    void LogEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, ...);
+    void LogEntryV(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, va_list arguments);
+    void LogTraceEntry(const char* function_name, const char* format, ...);
+    void LogHexDumpEntry(const void* data, size_t size, const char* format, ...);
+    LOGGER_COLD void LogFatalErrorEntry(const char* format, ...);
+
+    // Same as above, but for arguments formatted by LoggerFormatter. Message is appended directly to entry.
     template <typename... Types>
-    void LogEntry(const std::string& category_name, const std::string& format, Types&&... arguments);
+    void LogFormattedEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, const Types&... arguments);
+
+    // Same as above, but message is produced by function.
+    template <typename FunctionType>
+    void LogFunctionEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, FunctionType& function);
+
+    // Appends end of line to entry and outputs it.
+    void OutputEntry(StatsIndex stats_index, int severity, std::string& entry, std::chrono::steady_clock::time_point begin);
+    void OutputHexDumpEntry(std::string& entry, const void* data, size_t size, std::chrono::steady_clock::time_point begin);
+    LOGGER_COLD void LogFatalErrorMessage(const std::string& message);
 
-    void LogTime();
+    // Returns category prefix of trace: "[Trace][<function_name>]: ".
+    static std::string GenerateTraceCategoryPrefix(const char* function_name);
 
-    void InnerFatalError(const char* message, const wchar_t* message_utf16);
+    // Returns true, if all arguments can be passed to printf. Otherwise, message is formatted by AppendMessage.
+    template <typename... Types>
+    static constexpr bool IsPrintfArguments();
 
+    // Appends message to text. Arguments which can't be passed to printf are appended by LoggerFormatter.
     template <typename... Types>
-    std::string GenerateMessage(const std::string& format, Types&&... arguments);
+    void AppendMessage(std::string& text, const char* format, const Types&... arguments);
+
+    template <typename Type>
+    void AppendArgument(std::string& text, const char*& format, const Type& argument);
+
+    // Appends text of format until next format specifier, which is copied to specifier and skipped in format.
+    // Returns conversion character of specifier, or 0 at end of format.
+    char AppendFormatUntilSpecifier(std::string& text, const char*& format, char* specifier, size_t specifier_size);
+
+    // Formats directly to the end of text.
+    void AppendFormatted(std::string& text, const char* format, ...);
+    void AppendFormattedV(std::string& text, const char* format, va_list arguments);
+
+    // category_prefix      Prefix of category: "[<name>]: ".
+    std::string GenerateEntryPrefix(const char* category_prefix, size_t category_prefix_length);
+
+    template <typename CategoryType>
+    std::string GenerateEntryPrefix();
+
+    // Appends hex dump lines of data to text.
+    void AppendHexDump(std::string& text, const unsigned char* data, size_t size);
+
+    // severity             Severity of category of text, used by socket sink.
+    void OutputText(const std::string& text, int severity);
+    void OutputSpans(const LoggerSpan* spans, size_t span_count, int severity);
+
+    void CountSuppressed();
+    void CountEntry(StatsIndex stats_index, size_t length, std::chrono::steady_clock::time_point begin);
+    void LogStatsIfDue(std::chrono::steady_clock::time_point now);
+
+    std::string GenerateTime();
+
+    LOGGER_COLD void InnerFatalError(const char* message, const wchar_t* message_utf16);
+
+    // Closes asynchronous standard output and socket, so entries waiting in their buffers are written before exit.
+    LOGGER_COLD void CloseAsyncOutputs();
+
+    std::string GenerateMessage(const char* format, ...);
+    std::string GenerateMessageV(const char* format, va_list arguments);
 
     std::wstring ToUTF16(const std::string& text_utf8);
 
+    void WriteText(const std::string& text, int severity);
+    void WriteSpans(const LoggerSpan* spans, size_t span_count, int severity);
+    void WriteToFile(const char* text, size_t length);
+    void WriteToFile(const LoggerSpan* spans, size_t span_count);
+
+    // Returns false if text could not be written.
+    bool TryWriteToFile(const LoggerSpan* spans, size_t span_count);
+
+    // Writes file batch to file or queues it as block for compression.
+    void WriteFileBatch();
+
+    // Without time of entry (see GetThreadEntryTimeRef), clock is read only at beginning of span 
+    // and at each INDEX_TIME_CHECK_INTERVAL-th entry of span.
+    enum { INDEX_TIME_CHECK_INTERVAL = 64 };
+
+    void IndexEntry(size_t length, int severity);
+    void WriteIndexRecord();
+    static int64_t GetSystemTimeNS();
+
+    enum { MAX_COMPRESS_PENDING_COUNT = 16 };
+
+    void CompressBlocks();
+    void WaitForCompressedBlocks();
+
+    struct Shard {
+        FILE*       file;
+        std::string file_name;
+    };
+
+    struct ThreadShard {
+        uint64_t    session_id;
+        Shard*      shard;
+    };
+
+    // Ids of shard sessions which are opened, in all loggers.
+    struct ShardSessions {
+        std::mutex          mutex;
+        std::set<uint64_t>  live_ids;
+    };
+
+    static ShardSessions& GetShardSessionsRef();
+
+    void WriteToShard(uint64_t session_id, const LoggerSpan* spans, size_t span_count, size_t length);
+    void CloseShards();
+
+    static std::string& GetThreadNameRef();
+    static std::string& GetThreadContextRef();
+
+    // Returns reference to time of last entry generated by calling thread with time prefix, in nanoseconds since epoch.
+    // Used by index, so it doesn't read clock again. Zero when entry has no time prefix.
+    static int64_t& GetThreadEntryTimeRef();
+
+    // Returns reference to innermost scope tracked in calling thread.
+    static TrackedScope*& GetThreadTrackedScopeRef();
+
+    LOGGER_CATEGORY(SlowScope, "Slow Scope", LoggerCategory::Warning::SEVERITY);
+
+    LOGGER_COLD void LogSlowScope(const TrackedScope& scope, std::chrono::steady_clock::duration duration, std::chrono::steady_clock::duration threshold);
+
+    struct CallSiteRule {
+        std::string     pattern;
+        bool            is_enabled;
+    };
+
+    struct CallSites {
+        std::mutex                  mutex;
+        const LoggerCallSite*       first;
+        std::vector<CallSiteRule>   rules;      // applied in order to each registered call site
+    };
+
+    static CallSites& GetCallSitesRef();
+    static void SetCallSites(const std::string& pattern, bool is_enabled);
+    static std::vector<ThreadShard>& GetThreadShards();
+
+    // Returns length of valid utf-8 sequence at beginning of text or 0 if sequence is invalid.
+    // For invalid sequence, 'invalid_length' receives length of its maximal invalid subpart.
+    static size_t DecodeUTF8Sequence(const unsigned char* text, size_t size, size_t& invalid_length);
+
+    std::string             m_name;
+    Logger*                 m_output;
+    std::recursive_mutex    m_output_mutex;
+
     FILE*                   m_file;
+    size_t                  m_file_batch_size;
+    std::string             m_file_batch;
     bool                    m_is_stdout;
     DoAtFatalErrorFnP_T     m_do_at_fatal_error;
 
@@ -169,10 +1424,278 @@ private:
     bool                    m_is_log_dump;
     bool                    m_is_log_event;
     bool                    m_is_log_warning;
+    bool                    m_is_sanitize_utf8;
+    bool                    m_is_collect_stats;
+    size_t                  m_hex_dump_limit;
+    int                     m_min_severity;
+    uint64_t                m_disabled_categories;  // bit for each category declared by LOGGER_CATEGORY
+
+    AtomicCategoryStats     m_stats_categories[STATS_COUNT];
+    std::atomic<uint64_t>   m_stats_suppressed_count;
+    std::atomic<uint64_t>   m_stats_dropped_count;
+    std::atomic<uint64_t>   m_stats_flush_count;
+    std::atomic<uint64_t>   m_stats_format_time_ns;
+    std::atomic<uint64_t>   m_stats_write_time_ns;
+    std::atomic<uint64_t>   m_stats_max_batch_length;
+
+    std::atomic<int64_t>    m_stats_interval_ns;
+    std::atomic<int64_t>    m_stats_next_log_time_ns;
+    std::atomic<uint64_t>   m_stats_shed_count;
+
+    std::atomic<uint64_t>   m_budget_bytes_per_second;
+    std::atomic<uint64_t>   m_budget_memory_bytes;
+    std::atomic<int64_t>    m_budget_window_begin_ns;
+    std::atomic<uint64_t>   m_budget_window_bytes;
+    std::atomic<uint64_t>   m_budget_shed_counts[SHED_COUNT];
+
+    std::mutex                              m_metric_mutex;
+    std::vector<std::unique_ptr<Metric>>    m_metrics;
+    uint64_t                                m_metric_session_id;
+    std::thread                             m_metric_thread;
+    std::mutex                              m_metric_tick_mutex;
+    std::condition_variable                 m_metric_tick_condition;
+    unsigned                                m_metric_interval_ms;
+    bool                                    m_is_metric_tick_stop;
+
+    std::mutex                              m_dump_provider_mutex;
+    std::condition_variable                 m_dump_provider_condition;
+    std::vector<DumpProvider>               m_dump_providers;
+    size_t                                  m_last_dump_provider_id;
+    std::thread                             m_dump_provider_thread;
+    bool                                    m_is_dump_provider_changed;
+    bool                                    m_is_dump_provider_stop;
+
+    FILE*                   m_index_file;
+    size_t                  m_index_entry_interval;
+    int64_t                 m_index_time_interval_ns;
+    uint64_t                m_index_file_size;          // bytes written to log file and waiting in batch
+    LoggerIndexSpan         m_index_span;
+    int64_t                 m_index_span_deadline_ns;   // time at which current span ends
+    int64_t                 m_index_time_ns;            // time of last indexed entry, never decreases
+
+    bool                    m_is_compressed;
+    LoggerCompression       m_compression;
+    std::thread             m_compress_thread;
+    std::mutex              m_compress_mutex;
+    std::condition_variable m_compress_condition;
+    std::deque<std::string> m_compress_queue;
+    size_t                  m_compress_pending_count;
+    std::atomic<uint64_t>   m_compress_pending_bytes;
+    bool                    m_is_compress_stop;
+    bool                    m_is_compress_failed;       // write of block failed in background thread
+
+    LoggerSharedRing        m_shared_ring;
+
+    // Created by OpenSocket with deleter, so layout of Logger doesn't depend on LOGGER_USE_SOCKET.
+    std::unique_ptr<LoggerSocketSink, void (*)(LoggerSocketSink*)> m_socket_sink;
+    std::atomic<bool>       m_is_socket_opened;
+
+    LoggerConsoleSink       m_console_sink;
+
+    std::atomic<uint64_t>   m_shard_session_id;
+    std::string             m_shard_file_name_prefix;
+    std::atomic<uint64_t>   m_shard_sequence;
+    uint64_t                m_shard_file_count;     // guarded by m_shard_mutex
+    std::mutex              m_shard_mutex;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+// Keeps loggers of hierarchical names (for example "net" and "net.http"), which share output of one root logger.
+// Each logger has its own options and logs entries prefixed with its name: "[net.http][Event]: ...".
+// Options of created logger are copied from its closest existing ancestor ("net" for "net.http") or from root logger.
+// Functions which open, close or configure output (OpenFile, OpenStdOut, SetFileBatchSize, ...) called on logger 
+// from registry act on root logger. Lookup of already created logger is lock-free: it reads immutable snapshot of 
+// name to logger map, which is copied and replaced under lock only when new logger is created. Replaced snapshots 
+// are freed with registry, since reader could still use them.
+class LOGGER_API LoggerRegistry {
+public:
+    LoggerRegistry();
+    virtual ~LoggerRegistry();
+
+    // Logger which owns output (file, standard output) shared by all loggers from registry.
+    Logger& GetRoot();
+
+    // Returns logger of given name. Creates logger at first call for the name.
+    // name             Names of hierarchy levels separated by '.'. Empty name means root logger.
+    Logger& Get(const std::string& name);
+
+private:
+    typedef std::map<std::string, Logger*> Snapshot;
+
+    Logger                                          m_root;
+
+    std::atomic<const Snapshot*>                    m_snapshot;
+
+    // Guarded by m_mutex.
+    std::mutex                                      m_mutex;
+    std::map<std::string, std::unique_ptr<Logger>>  m_loggers;
+    std::vector<std::unique_ptr<const Snapshot>>    m_snapshots;
+};
+
+// Encodes and decodes blocks of compressed log file. Each block is stored as frame:
+//      [magic "LGBK"][codec: 1 byte][reserved: 3 bytes][text size: 4 bytes][payload size: 4 bytes][payload]
+// Sizes are little-endian.
+class LOGGER_API LoggerBlockCodec {
+public:
+    enum { 
+        HEADER_SIZE = 16,
+        MAX_BLOCK_SIZE = 0x7FFFFFFF
+    };
+
+    enum Codec {
+        CODEC_STORED    = 0,
+        CODEC_LZ        = 1,
+        CODEC_ZLIB      = 2
+    };
+
+    struct Header {
+        Codec       codec;
+        uint32_t    text_size;
+        uint32_t    payload_size;
+    };
+
+    // Appends frame with compressed text to 'frame'.
+    // Stores text without compression, if compression doesn't reduce its size.
+    static void AppendFrame(std::string& frame, LoggerCompression compression, const char* text, size_t size);
+
+    // Returns false if header is not valid.
+    static bool DecodeHeader(const unsigned char* data, Header& header);
+
+    // Returns false if payload is corrupted or its codec is not available.
+    static bool DecodePayload(const Header& header, const char* payload, std::string& text);
+
+    static void CompressLZ(const char* text, size_t size, std::string& compressed);
+    static bool DecompressLZ(const char* compressed, size_t size, size_t text_size, std::string& text);
+
+private:
+    static void WriteUInt32(unsigned char* data, uint32_t value);
+    static uint32_t ReadUInt32(const unsigned char* data);
+};
+
+// Collects entries written to shared memory ring by loggers of many processes and writes them to one logger.
+// Thus one process writes to log file.
+class LOGGER_API LoggerCollector {
+public:
+    LoggerCollector();
+    virtual ~LoggerCollector();
+
+    // Creates shared memory ring. Returns false if it can not be created or it already exists.
+    // name                 Name of shared memory. Encoding: ASCII or UTF8. 
+    // slot_count           Number of slots in ring.
+    // slot_size            Size of slot in bytes. Entry longer than slot occupies many slots.
+    bool Create(const std::string& name, size_t slot_count = 4096, size_t slot_size = 256);
+    void Destroy();
+
+    // Sets time after which reserved, but not committed slot is treated as abandoned by crashed process (default: 1000).
+    void SetAbandonTimeout(unsigned abandon_timeout_ms);
+
+    // Writes all entries, which are in ring, to logger. Returns number of written entries.
+    size_t Collect(Logger& logger);
+
+    // Starts thread, which collects entries to logger every 'interval_ms'.
+    void Start(Logger& logger, unsigned interval_ms = 10);
+
+    // Stops thread and collects remaining entries.
+    void Stop();
+
+    // Number of entries dropped by loggers because ring was full.
+    uint64_t GetDroppedCount() const;
+
+    // Number of slots abandoned by crashed processes.
+    uint64_t GetAbandonedCount() const;
+
+private:
+    LoggerSharedRing        m_ring;
+    unsigned                m_abandon_timeout_ms;
+    std::string             m_text;
+
+    Logger*                 m_logger;
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    bool                    m_is_stop;
+};
+
+// Reads log file written by Logger::OpenCompressedFile.
+// Opening reads only headers of blocks, so any block can be decompressed without decompressing preceding ones.
+// Incomplete block at end of file (for example after crash) is ignored.
+class LOGGER_API LoggerCompressedFileReader {
+public:
+    LoggerCompressedFileReader();
+    virtual ~LoggerCompressedFileReader();
+
+    // Returns false if file can not be opened or it isn't compressed log file.
+    bool Open(const std::string& file_name);
+    void Close();
+    bool IsOpened() const;
+
+    size_t GetBlockCount() const;
+
+    // Returns position of first character of block in whole decompressed text.
+    uint64_t GetBlockTextOffset(size_t index) const;
+
+    // Returns false if block can not be read or decompressed.
+    bool ReadBlock(size_t index, std::string& text);
+
+    // Decompresses all blocks.
+    bool ReadAll(std::string& text);
+
+    // Decompresses compressed log file into plain text file.
+    static bool DecompressFile(const std::string& file_name, const std::string& output_file_name);
+
+private:
+    struct Block {
+        LoggerBlockCodec::Header    header;
+        int64_t                     file_offset;    // of payload
+        uint64_t                    text_offset;
+    };
+
+    FILE*               m_file;
+    std::vector<Block>  m_blocks;
 };
 
-#define LOGGER_TRACE(logger, ...) logger.LogTrace(__FUNCTION__ , __VA_ARGS__)
-#define LOGGER_TRACK(logger) Logger::Tracker l_tracker(logger, __FUNCTION__)
+// Reads log file written by Logger::OpenIndexedFile and finds entries logged in time range by its sidecar index.
+class LOGGER_API LoggerIndexedFileReader {
+public:
+    LoggerIndexedFileReader();
+    virtual ~LoggerIndexedFileReader();
+
+    // Returns false if file or its index can not be opened or index isn't valid.
+    // Text written after last record of index (e.g. before crash) is counted to last span.
+    bool Open(const std::string& file_name);
+    void Close();
+    bool IsOpened() const;
+
+    size_t GetSpanCount() const;
+    const LoggerIndexSpan& GetSpan(size_t index) const;
+
+    // Reads text of all spans with entries logged in time range: [begin_time, end_time).
+    // Text starts and ends at boundaries of spans, so it can contain entries logged just outside of time range.
+    // Returns false if text can not be read.
+    bool ReadTimeRange(std::chrono::system_clock::time_point begin_time, std::chrono::system_clock::time_point end_time, std::string& text);
+
+    // Writes entries logged in time range to plain text file, see ReadTimeRange.
+    static bool ExtractTimeRange(const std::string& file_name, std::chrono::system_clock::time_point begin_time, std::chrono::system_clock::time_point end_time, const std::string& output_file_name);
+
+private:
+    FILE*                           m_file;
+    std::vector<LoggerIndexSpan>    m_spans;
+};
+
+#define LOGGER_TRACE(logger, ...) \
+    do { \
+        static LoggerCallSite s_logger_call_site(__FILE__, __LINE__, __FUNCTION__, LoggerCategory::Trace::NAME); \
+        if (s_logger_call_site.IsEnabled()) logger.LogTrace(__FUNCTION__ , __VA_ARGS__); \
+    } while (false)
+
+#define LOGGER_TRACK(logger) \
+    static LoggerCallSite s_logger_track_call_site(__FILE__, __LINE__, __FUNCTION__, LoggerCategory::Trace::NAME); \
+    Logger::Tracker l_tracker(logger, __FUNCTION__, &s_logger_track_call_site)
+
+// Logs entry at exit from scope, only if scope took longer than threshold, see Logger::SlowTracker.
+// threshold            Duration, for example: std::chrono::milliseconds(10).
+#define LOGGER_TRACK_SLOW(logger, threshold) \
+    Logger::SlowTracker l_slow_tracker(logger, __FUNCTION__, threshold)
 
 //------------------------------------------------------------------------------
 // Definition
@@ -180,267 +1703,337 @@ private:
 
 #define TOSTR_INNER_FATAL_ERROR(message) InnerFatalError(message, L##message)
 
-inline Logger::Logger() {
-    m_file              = nullptr;
-    m_is_stdout         = false;
-    m_do_at_fatal_error = nullptr;
+// Templates and functions inlined at call site. Other definitions are in LoggerImpl.h.
 
-    m_is_log_time       = false;
-    m_is_log_trace      = true;
-    m_is_log_dump       = true;
-    m_is_log_event      = true;
-    m_is_log_warning    = true;
+template <typename CategoryType>
+void Logger::Enable() {
+    SetCategory<CategoryType>(true);
 }
 
-inline Logger::~Logger() {
-    CloseFile();
+template <typename CategoryType>
+void Logger::Disable() {
+    SetCategory<CategoryType>(false);
 }
 
-//------------------------------------------------------------------------------
-
-inline void Logger::OpenFile(const std::string& file_name, bool is_append) {
-    CloseFile();
-    if (_wfopen_s(&m_file, ToUTF16(file_name).c_str(), is_append ? L"ab" : L"wb") != 0 || !m_file) {
-        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenFile: Can not open log file.");
+template <typename CategoryType>
+void Logger::SetCategory(bool is) {
+    static_assert(!std::is_same<CategoryType, LoggerCategory::Error>::value && !std::is_same<CategoryType, LoggerCategory::FatalError>::value, 
+        "Error and fatal error can not be enabled or disabled.");
+
+    if constexpr (std::is_same<CategoryType, LoggerCategory::Trace>::value) {
+        SetOption(LoggerOption::LOG_TRACE, is);
+    } else if constexpr (std::is_same<CategoryType, LoggerCategory::Dump>::value) {
+        SetOption(LoggerOption::LOG_DUMP, is);
+    } else if constexpr (std::is_same<CategoryType, LoggerCategory::Event>::value) {
+        SetOption(LoggerOption::LOG_EVENT, is);
+    } else if constexpr (std::is_same<CategoryType, LoggerCategory::Warning>::value) {
+        SetOption(LoggerOption::LOG_WARNING, is);
+    } else {
+        const size_t index = GetCategoryIndex<CategoryType>();
+        if (index < 64) {
+            if (is) {
+                m_disabled_categories &= ~(uint64_t(1) << index);
+            } else {
+                m_disabled_categories |= uint64_t(1) << index;
+            }
+        }
     }
 }
 
-inline void Logger::CloseFile() {
-    if (m_file) {
-        fclose(m_file);
-        m_file = nullptr;
+template <typename CategoryType>
+bool Logger::IsEnabled() const {
+    if constexpr (std::is_same<CategoryType, LoggerCategory::Error>::value || std::is_same<CategoryType, LoggerCategory::FatalError>::value) {
+        return true;
+    } else {
+        if (CategoryType::SEVERITY < m_min_severity) return false;
+
+        if constexpr (std::is_same<CategoryType, LoggerCategory::Trace>::value) {
+            return m_is_log_trace;
+        } else if constexpr (std::is_same<CategoryType, LoggerCategory::Dump>::value) {
+            return m_is_log_dump;
+        } else if constexpr (std::is_same<CategoryType, LoggerCategory::Event>::value) {
+            return m_is_log_event;
+        } else if constexpr (std::is_same<CategoryType, LoggerCategory::Warning>::value) {
+            return m_is_log_warning;
+        } else {
+            const size_t index = GetCategoryIndex<CategoryType>();
+            return index >= 64 || !(m_disabled_categories & (uint64_t(1) << index));
+        }
     }
 }
 
-inline bool Logger::IsFileOpened() const { 
-    return m_file != nullptr; 
+template <typename CategoryType>
+constexpr Logger::StatsIndex Logger::GetStatsIndex() {
+    return  std::is_same<CategoryType, LoggerCategory::Trace>::value        ? STATS_TRACE :
+            std::is_same<CategoryType, LoggerCategory::Dump>::value         ? STATS_DUMP :
+            std::is_same<CategoryType, LoggerCategory::Event>::value        ? STATS_EVENT :
+            std::is_same<CategoryType, LoggerCategory::Warning>::value      ? STATS_WARNING :
+            std::is_same<CategoryType, LoggerCategory::Error>::value        ? STATS_ERROR :
+            std::is_same<CategoryType, LoggerCategory::FatalError>::value   ? STATS_FATAL_ERROR :
+                                                                              STATS_CUSTOM;
 }
 
-inline void Logger::OpenStdOut() {
-    m_is_stdout = true;
+template <typename CategoryType>
+size_t Logger::GetCategoryIndex() {
+    static const size_t s_index = GetCategoryCountRef().fetch_add(1);
+    return s_index;
 }
 
-inline void Logger::CloseStdOut() {
-    m_is_stdout = false;
-}
+inline bool Logger::IsShed(int severity) {
+    if (severity >= LoggerCategory::Warning::SEVERITY) return false;
 
-inline bool Logger::IsStdOutOpened() const { 
-    return m_is_stdout; 
+    Logger& output = m_output ? *m_output : *this;
+    return output.m_budget_bytes_per_second.load(std::memory_order_relaxed) != 0 && IsShedByBudget(output, severity);
 }
 
 //------------------------------------------------------------------------------
 
-inline void Logger::SetDoAtFatalError(DoAtFatalErrorFnP_T do_at_fatal_error) { 
-    m_do_at_fatal_error = do_at_fatal_error; 
+inline void Logger::CountSuppressed() {
+    if (m_is_collect_stats) m_stats_suppressed_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 //------------------------------------------------------------------------------
 
-inline void Logger::Enable(LoggerOption option) {
-    SetOption(option, true);
+inline bool LoggerCallSite::IsEnabled() const {
+    const uint8_t state = m_state.load(std::memory_order_relaxed);
+    if (state != STATE_UNREGISTERED) return state == STATE_ENABLED;
+    return Register();
 }
-inline void Logger::Disable(LoggerOption option) {
-    SetOption(option, false);
+
+inline Logger::Tracker::Tracker(Logger& logger, const char* function_name, const LoggerCallSite* call_site) : m_logger(logger) {
+    TrackedScope*& thread_scope = GetThreadTrackedScopeRef();
+    m_scope         = {function_name, thread_scope};
+    thread_scope    = &m_scope;
+
+    m_is_enabled = !call_site || call_site->IsEnabled();
+    if (m_is_enabled) logger.LogTrace(function_name, "Enter.");
 }
 
-inline void Logger::SetOption(LoggerOption option, bool is) {
-    switch (option) {
-        case LoggerOption::LOG_TIME:    m_is_log_time       = is; break;
-        case LoggerOption::LOG_TRACE:   m_is_log_trace      = is; break;
-        case LoggerOption::LOG_DUMP:    m_is_log_dump       = is; break;
-        case LoggerOption::LOG_EVENT:   m_is_log_event      = is; break;
-        case LoggerOption::LOG_WARNING: m_is_log_warning    = is; break;
-    }
+inline Logger::Tracker::~Tracker() {
+    if (m_is_enabled) m_logger.LogTrace(m_scope.function_name, "Exit.");
+
+    GetThreadTrackedScopeRef() = m_scope.parent;
 }
 
-//------------------------------------------------------------------------------
+inline Logger::SlowTracker::SlowTracker(Logger& logger, const char* function_name, std::chrono::steady_clock::duration threshold) : m_logger(logger), m_threshold(threshold) {
+    TrackedScope*& thread_scope = GetThreadTrackedScopeRef();
+    m_scope         = {function_name, thread_scope};
+    thread_scope    = &m_scope;
 
-inline void Logger::LogText(const std::string& text) {
-    if (m_file) {
-        const size_t count = fwrite(text.c_str(), sizeof(char), text.length(), m_file);
-        if (count != text.length()) {
-            TOSTR_INNER_FATAL_ERROR("Logger::LogText: Failed write the text to the log file.");
-        }
+    m_begin = std::chrono::steady_clock::now();
+}
 
-        fflush(m_file);
+inline Logger::SlowTracker::~SlowTracker() {
+    const auto duration = std::chrono::steady_clock::now() - m_begin;
+    if (duration > m_threshold) m_logger.LogSlowScope(m_scope, duration, m_threshold);
+
+    GetThreadTrackedScopeRef() = m_scope.parent;
+}
+
+template <typename... Types>
+void Logger::LogText(LoggerStringRef format, Types&&... arguments) {
+    if constexpr (IsPrintfArguments<Types...>()) {
+        LogText(GenerateMessage(format.c_str(), std::forward<Types>(arguments)...));
+    } else {
+        std::string text;
+        AppendMessage(text, format.c_str(), arguments...);
+        LogText(text);
     }
-    if (m_is_stdout) {
-        UTF8_Guardian utf8_guardian;
+}
 
-        if (fwide(stdout, 0) > 0) {
-            wprintf(L"%ls", ToUTF16(text).c_str());
+template <typename CategoryType, typename... Types>
+void Logger::Log(LoggerStringRef format, Types&&... arguments) {
+    if (IsEnabled<CategoryType>()) {
+        if (IsShed(CategoryType::SEVERITY)) return;
+
+        if constexpr (IsPrintfArguments<Types...>()) {
+            LogEntry(GetStatsIndex<CategoryType>(), CategoryType::SEVERITY, LoggerCategoryPrefix<CategoryType>::TEXT.data(), LoggerCategoryPrefix<CategoryType>::LENGTH, format.c_str(), std::forward<Types>(arguments)...);
         } else {
-            printf("%s", text.c_str());
+            LogFormattedEntry(GetStatsIndex<CategoryType>(), CategoryType::SEVERITY, LoggerCategoryPrefix<CategoryType>::TEXT.data(), LoggerCategoryPrefix<CategoryType>::LENGTH, format.c_str(), arguments...);
         }
-        fflush(stdout);
+    } else {
+        CountSuppressed();
     }
 }
 
-template <typename... Types>
-void Logger::LogText(const std::string& format, Types&&... arguments) {
-    LogText(GenerateMessage(format, std::forward<Types>(arguments)...));
-}
+template <typename CategoryType, typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type>
+void Logger::Log(FunctionType&& function) {
+    if (IsEnabled<CategoryType>()) {
+        if (IsShed(CategoryType::SEVERITY)) return;
 
-template <typename... Types>
-void Logger::LogTrace(const std::string& function_name, const std::string& format, Types&&... arguments) {
-    if (m_is_log_trace) {
-        if (m_is_log_time) LogTime();
-        LogText("[Trace][%s]: ", function_name.c_str());
-        LogText(format, std::forward<Types>(arguments)...);
-        LogText("\n");
+        LogFunctionEntry(GetStatsIndex<CategoryType>(), CategoryType::SEVERITY, LoggerCategoryPrefix<CategoryType>::TEXT.data(), LoggerCategoryPrefix<CategoryType>::LENGTH, function);
+    } else {
+        CountSuppressed();
     }
 }
-template <typename... Types>
-void Logger::LogDump(const std::string& format, Types&&... arguments) {
-    if (m_is_log_dump) LogEntry("Dump", format, std::forward<Types>(arguments)...);
-} 
-
-template <typename... Types>
-void Logger::LogEvent(const std::string& format, Types&&... arguments) {
-    if (m_is_log_event) LogEntry("Event", format, std::forward<Types>(arguments)...);
-} 
 
 template <typename... Types>
-void Logger::LogWarning(const std::string& format, Types&&... arguments) {
-    if (m_is_log_warning) LogEntry("Warning", format, std::forward<Types>(arguments)...);
-} 
+void Logger::LogTrace(LoggerStringRef function_name, LoggerStringRef format, Types&&... arguments) {
+    if (IsEnabled<LoggerCategory::Trace>()) {
+        if (IsShed(LoggerCategory::Trace::SEVERITY)) return;
 
-template <typename... Types>
-void Logger::LogError(const std::string& format, Types&&... arguments) {
-    LogEntry("Error", format, std::forward<Types>(arguments)...);
-} 
+        if constexpr (IsPrintfArguments<Types...>()) {
+            LogTraceEntry(function_name.c_str(), format.c_str(), std::forward<Types>(arguments)...);
+        } else {
+            const std::string category_prefix = GenerateTraceCategoryPrefix(function_name.c_str());
+            LogFormattedEntry(STATS_TRACE, LoggerCategory::Trace::SEVERITY, category_prefix.c_str(), category_prefix.length(), format.c_str(), arguments...);
+        }
+    } else {
+        CountSuppressed();
+    }
+}
 
-template <typename... Types>
-void Logger::LogFatalError(const std::string& format, Types&&... arguments) {
-    const std::string message = GenerateMessage(format, std::forward<Types>(arguments)...);
-    LogEntry("Fatal Error", message);
+template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type>
+void Logger::LogTrace(LoggerStringRef function_name, FunctionType&& function) {
+    if (IsEnabled<LoggerCategory::Trace>()) {
+        if (IsShed(LoggerCategory::Trace::SEVERITY)) return;
 
-    if (m_do_at_fatal_error) m_do_at_fatal_error(message.c_str()); 
-    exit(EXIT_FAILURE);
+        const std::string category_prefix = GenerateTraceCategoryPrefix(function_name.c_str());
+        LogFunctionEntry(STATS_TRACE, LoggerCategory::Trace::SEVERITY, category_prefix.c_str(), category_prefix.length(), function);
+    } else {
+        CountSuppressed();
+    }
 }
 
 template <typename... Types>
-void Logger::LogEntry(const std::string& category_name, const std::string& format, Types&&... arguments) {
-    if (m_is_log_time) LogTime();
-    LogText("[%s]: ", category_name.c_str());
-    LogText(format, std::forward<Types>(arguments)...);
-    LogText("\n");
+void Logger::LogDump(LoggerStringRef format, Types&&... arguments) {
+    Log<LoggerCategory::Dump>(format, std::forward<Types>(arguments)...);
 } 
 
-//------------------------------------------------------------------------------
-
-inline void Logger::LogTime() {
-    const time_t now = time(NULL);
-    tm ti = {};
-    localtime_s(&ti, &now);
-
-    LogText("[%d/%02d/%02d %02d:%02d:%02d]", 1900 + ti.tm_year, 1 + ti.tm_mon, ti.tm_mday, ti.tm_hour, ti.tm_min, ti.tm_sec);
-}
+template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type>
+void Logger::LogDump(FunctionType&& function) {
+    Log<LoggerCategory::Dump>(std::forward<FunctionType>(function));
+} 
 
-inline void Logger::InnerFatalError(const char* message, const wchar_t* message_utf16) {
-    {
-        UTF8_Guardian utf8_guardian;
+template <typename... Types>
+void Logger::LogHexDump(const void* data, size_t size, LoggerStringRef format, Types&&... arguments) {
+    if (IsEnabled<LoggerCategory::Dump>()) {
+        if (IsShed(LoggerCategory::Dump::SEVERITY)) return;
 
-        if (fwide(stdout, 0) > 0) {
-            wprintf(L"%ls\n", message_utf16);
+        if constexpr (IsPrintfArguments<Types...>()) {
+            LogHexDumpEntry(data, size, format.c_str(), std::forward<Types>(arguments)...);
         } else {
-            printf("%s\n", message);
+            const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+            std::string entry = GenerateEntryPrefix<LoggerCategory::Dump>();
+            AppendMessage(entry, format.c_str(), arguments...);
+            OutputHexDumpEntry(entry, data, size, begin);
         }
-        fflush(stdout);
+    } else {
+        CountSuppressed();
     }
-
-    if (m_do_at_fatal_error) m_do_at_fatal_error(message);
-    exit(EXIT_FAILURE);
 }
 
 template <typename... Types>
-std::string Logger::GenerateMessage(const std::string& format, Types&&... arguments) {
-    std::string message;
+void Logger::LogEvent(LoggerStringRef format, Types&&... arguments) {
+    Log<LoggerCategory::Event>(format, std::forward<Types>(arguments)...);
+} 
 
-    enum { SIZE = 4096 };
-    char stack_buffer[SIZE];
+template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type>
+void Logger::LogEvent(FunctionType&& function) {
+    Log<LoggerCategory::Event>(std::forward<FunctionType>(function));
+} 
 
-    #ifndef _MSC_VER 
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wformat-security"
-    #endif
+template <typename... Types>
+void Logger::LogWarning(LoggerStringRef format, Types&&... arguments) {
+    Log<LoggerCategory::Warning>(format, std::forward<Types>(arguments)...);
+} 
 
-    const int count = snprintf(stack_buffer, SIZE, format.c_str(), std::forward<Types>(arguments)...);
+template <typename FunctionType, typename std::enable_if<LoggerIsMessageFunction<FunctionType>::value, int>::type>
+void Logger::LogWarning(FunctionType&& function) {
+    Log<LoggerCategory::Warning>(std::forward<FunctionType>(function));
+} 
 
-    #ifndef _MSC_VER 
-        #pragma GCC diagnostic pop
-    #endif
+template <typename... Types>
+void Logger::LogError(LoggerStringRef format, Types&&... arguments) {
+    Log<LoggerCategory::Error>(format, std::forward<Types>(arguments)...);
+    Flush();
+} 
 
-    if (count < 0) {
-        TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Wrong encoding.");
+template <typename... Types>
+void Logger::LogFatalError(LoggerStringRef format, Types&&... arguments) {
+    if constexpr (IsPrintfArguments<Types...>()) {
+        LogFatalErrorEntry(format.c_str(), std::forward<Types>(arguments)...);
+    } else {
+        std::string message;
+        AppendMessage(message, format.c_str(), arguments...);
+        LogFatalErrorMessage(message);
     }
+}
 
-    if (count >= SIZE) {
-        char* buffer = new char[count];
-
-        #ifndef _MSC_VER 
-            #pragma GCC diagnostic push
-            #pragma GCC diagnostic ignored "-Wformat-security"
-        #endif
-
-        const int second_count = snprintf(buffer, count, format.c_str(), std::forward<Types>(arguments)...);
-
-        #ifndef _MSC_VER 
-            #pragma GCC diagnostic pop
-        #endif
+template <typename... Types>
+void Logger::LogFormattedEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, const Types&... arguments) {
+    const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
 
-        if (count < 0) {
-            TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Wrong encoding (at second try).");
-        }
-        if (second_count > count) {
-            TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Can not write to buffer.");
-        }
+    std::string entry = GenerateEntryPrefix(category_prefix, category_prefix_length);
+    AppendMessage(entry, format, arguments...);
+    OutputEntry(stats_index, severity, entry, begin);
+}
 
-        if (second_count > 0) message = std::string(buffer, second_count);
+template <typename FunctionType>
+void Logger::LogFunctionEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, FunctionType& function) {
+    const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
 
-        delete[] buffer;
+    std::string entry = GenerateEntryPrefix(category_prefix, category_prefix_length);
+    if constexpr (std::is_invocable<FunctionType&, std::string&>::value) {
+        function(entry);
     } else {
-        message = std::string(stack_buffer, count);
+        AppendMessage(entry, "%s", function());
     }
-
-    return message;
+    OutputEntry(stats_index, severity, entry, begin);
 }
 
-inline std::wstring Logger::ToUTF16(const std::string& text_utf8) {
-    std::wstring text_utf16;
-
-    enum { DEFAULT_SIZE = 4096 };
-    wchar_t stack_buffer[DEFAULT_SIZE] = {};
+template <typename... Types>
+constexpr bool Logger::IsPrintfArguments() {
+    return (... && (std::is_arithmetic<typename std::decay<Types>::type>::value || 
+                    std::is_pointer<typename std::decay<Types>::type>::value || 
+                    std::is_null_pointer<typename std::decay<Types>::type>::value));
+}
 
-    if (!text_utf8.empty()) {
-        int size = MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, NULL, 0);
-        if (size == 0) {
-            TOSTR_INNER_FATAL_ERROR("Error Logger::ToUTF16: Can not convert a text from utf-16 to utf-8.");
-        }
+template <typename... Types>
+void Logger::AppendMessage(std::string& text, const char* format, const Types&... arguments) {
+    (AppendArgument(text, format, arguments), ...);
 
-        wchar_t* buffer = (size > DEFAULT_SIZE) ? (new wchar_t[size]) : stack_buffer;
+    // Specifiers without arguments are logged as they are.
+    enum { SPECIFIER_SIZE = 32 };
+    char specifier[SPECIFIER_SIZE];
+    while (AppendFormatUntilSpecifier(text, format, specifier, SPECIFIER_SIZE) != 0) text += specifier;
+}
 
-        size = MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, buffer, size);
-        if (size == 0) {
-            TOSTR_INNER_FATAL_ERROR("Error Logger::ToUTF16: Can not convert a text from utf-16 to utf-8.");
+template <typename Type>
+void Logger::AppendArgument(std::string& text, const char*& format, const Type& argument) {
+    using DecayedType = typename std::decay<Type>::type;
+
+    enum { SPECIFIER_SIZE = 32 };
+    char specifier[SPECIFIER_SIZE];
+    const char conversion = AppendFormatUntilSpecifier(text, format, specifier, SPECIFIER_SIZE);
+    if (conversion == 0) return;
+
+    if constexpr (std::is_arithmetic<DecayedType>::value || std::is_enum<DecayedType>::value) {
+        // Number logged by '%s' is appended by LoggerFormatter, by other specifiers is formatted by printf.
+        if (conversion == 's') {
+            LoggerFormatter<DecayedType>::Append(text, argument);
+        } else if constexpr (std::is_enum<DecayedType>::value) {
+            AppendFormatted(text, specifier, static_cast<typename std::underlying_type<DecayedType>::type>(argument));
+        } else {
+            AppendFormatted(text, specifier, argument);
         }
-
-        if (size > 1) text_utf16 = std::wstring(buffer, size - 1);
-
-        if (buffer != stack_buffer) delete[] buffer;
+    } else if constexpr (IsPrintfArguments<Type>()) {
+        AppendFormatted(text, specifier, argument);
+    } else {
+        LoggerFormatter<DecayedType>::Append(text, argument);
     }
+}
 
-    return text_utf16;
+template <typename CategoryType>
+std::string Logger::GenerateEntryPrefix() {
+    return GenerateEntryPrefix(LoggerCategoryPrefix<CategoryType>::TEXT.data(), LoggerCategoryPrefix<CategoryType>::LENGTH);
 }
 
 //------------------------------------------------------------------------------
 
-inline Logger::Tracker::Tracker(Logger& logger, const char* function_name) : m_logger(logger), m_function_name(function_name) {
-    logger.LogTrace(function_name, "Enter.");
-}
-
-inline Logger::Tracker::~Tracker() {
-    m_logger.LogTrace(m_function_name, "Exit.");
-}
+#ifndef LOGGER_COMPILED_LIB
+    #include "LoggerImpl.h"
+#endif
 
 #endif // LOGGER_H_
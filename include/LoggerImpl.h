@@ -0,0 +1,3694 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+// 
+// Copyright (c) 2023 underwatergrasshopper
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+* @file LoggerImpl.h
+* @author underwatergrasshopper
+* @version 2.0.1
+* 
+* Definitions of Logger.h, which aren't templates. 
+* Included by Logger.h in header-only mode and compiled once by src/Logger.cpp in compiled mode (LOGGER_COMPILED_LIB).
+*/
+
+#ifndef LOGGER_IMPL_H_
+#define LOGGER_IMPL_H_
+
+#include "Logger.h"
+
+#define WIN32_LEAN_AND_MEAN 
+#include <windows.h>
+#undef WIN32_LEAN_AND_MEAN 
+
+#ifdef LOGGER_USE_ZLIB
+    #include <zlib.h>
+#endif
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+    #include <emmintrin.h>
+    #define LOGGER_SSE2 1
+#else
+    #define LOGGER_SSE2 0
+#endif
+
+//------------------------------------------------------------------------------
+// Definition
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE Logger::Logger() : m_socket_sink(nullptr, nullptr) {
+    m_output            = nullptr;
+
+    m_file              = nullptr;
+    m_file_batch_size   = 0;
+    m_is_stdout         = false;
+    m_do_at_fatal_error = nullptr;
+
+    m_is_log_time           = false;
+    m_is_log_trace          = true;
+    m_is_log_dump           = true;
+    m_is_log_event          = true;
+    m_is_log_warning        = true;
+    m_is_sanitize_utf8      = false;
+    m_is_collect_stats      = false;
+    m_hex_dump_limit        = 65536;
+    m_min_severity          = 0;
+    m_disabled_categories   = 0;
+
+    m_stats_interval_ns         = 0;
+    m_stats_next_log_time_ns    = 0;
+    ResetStats();
+
+    m_budget_bytes_per_second   = 0;
+    m_budget_memory_bytes       = 0;
+    m_budget_window_begin_ns    = 0;
+    m_budget_window_bytes       = 0;
+    for (auto& shed_count : m_budget_shed_counts) shed_count = 0;
+
+    static std::atomic<uint64_t> s_last_metric_session_id(0);
+
+    m_metric_session_id         = ++s_last_metric_session_id;
+    {
+        MetricSessions& metric_sessions = GetMetricSessionsRef();
+        std::lock_guard<std::mutex> sessions_lock(metric_sessions.mutex);
+        metric_sessions.loggers[m_metric_session_id] = this;
+    }
+    m_metric_interval_ms        = 0;
+    m_is_metric_tick_stop       = false;
+
+    m_last_dump_provider_id     = 0;
+    m_is_dump_provider_changed  = false;
+    m_is_dump_provider_stop     = false;
+
+    m_is_socket_opened          = false;
+
+    m_index_file                = nullptr;
+    m_index_entry_interval      = 0;
+    m_index_time_interval_ns    = 0;
+    m_index_file_size           = 0;
+    m_index_span                = {};
+    m_index_span_deadline_ns    = 0;
+    m_index_time_ns             = 0;
+
+    m_is_compressed             = false;
+    m_compression               = LoggerCompression::LZ;
+    m_compress_pending_count    = 0;
+    m_compress_pending_bytes    = 0;
+    m_is_compress_stop          = false;
+    m_is_compress_failed        = false;
+
+    m_shard_session_id          = 0;
+    m_shard_sequence            = 0;
+    m_shard_file_count          = 0;
+}
+
+LOGGER_INLINE Logger::~Logger() {
+    // Exiting thread can't fold its accumulators into metrics of this logger anymore.
+    {
+        MetricSessions& metric_sessions = GetMetricSessionsRef();
+        std::lock_guard<std::mutex> sessions_lock(metric_sessions.mutex);
+        metric_sessions.loggers.erase(m_metric_session_id);
+    }
+
+    StopDumpProviders();
+    StopMetricTick();
+
+    // Output of logger from LoggerRegistry belongs to root logger.
+    if (!m_output) CloseFile();
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void Logger::OpenFile(const std::string& file_name, bool is_append) {
+    if (m_output) {
+        m_output->OpenFile(file_name, is_append);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    CloseFile();
+    if (_wfopen_s(&m_file, ToUTF16(file_name).c_str(), is_append ? L"ab" : L"wb") != 0 || !m_file) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenFile: Can not open log file.");
+    }
+}
+
+LOGGER_INLINE void Logger::CloseFile() {
+    if (m_output) {
+        m_output->CloseFile();
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    // Summary of entries shed in current window is logged before output is closed.
+    if (m_budget_bytes_per_second.load(std::memory_order_relaxed) != 0) LogBudgetSummary();
+
+    CloseShards();
+
+    if (m_file) {
+        Flush();
+
+        if (m_index_file) {
+            if (m_index_span.entry_count > 0) WriteIndexRecord();
+            fclose(m_index_file);
+            m_index_file = nullptr;
+        }
+
+        if (m_is_compressed) {
+            {
+                std::lock_guard<std::mutex> compress_lock(m_compress_mutex);
+                m_is_compress_stop = true;
+            }
+            m_compress_condition.notify_all();
+            m_compress_thread.join();
+
+            m_is_compressed     = false;
+            m_is_compress_stop  = false;
+            m_file_batch_size   = 0;
+            m_file_batch.clear();
+            m_file_batch.shrink_to_fit();
+        }
+
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+LOGGER_INLINE bool Logger::IsFileOpened() const {
+    if (m_output) return m_output->IsFileOpened();
+
+    return m_file != nullptr; 
+}
+
+LOGGER_INLINE void Logger::OpenCompressedFile(const std::string& file_name, bool is_append, LoggerCompression compression, size_t block_size) {
+    if (m_output) {
+        m_output->OpenCompressedFile(file_name, is_append, compression, block_size);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+#ifndef LOGGER_USE_ZLIB
+    if (compression == LoggerCompression::ZLIB) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenCompressedFile: Zlib compression is not available.");
+    }
+#endif
+    if (block_size == 0 || block_size > LoggerBlockCodec::MAX_BLOCK_SIZE) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenCompressedFile: Wrong block size.");
+    }
+
+    OpenFile(file_name, is_append);
+
+    SetFileBatchSize(block_size);
+
+    m_is_compressed             = true;
+    m_compression               = compression;
+    m_compress_pending_count    = 0;
+    m_is_compress_stop          = false;
+    m_is_compress_failed        = false;
+    m_compress_thread           = std::thread(&Logger::CompressBlocks, this);
+}
+
+LOGGER_INLINE bool Logger::IsCompressedFileOpened() const {
+    if (m_output) return m_output->IsCompressedFileOpened();
+
+    return m_file != nullptr && m_is_compressed;
+}
+
+LOGGER_INLINE void Logger::OpenIndexedFile(const std::string& file_name, bool is_append, size_t entry_interval, unsigned time_interval_ms) {
+    if (m_output) {
+        m_output->OpenIndexedFile(file_name, is_append, entry_interval, time_interval_ms);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    if (entry_interval == 0) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenIndexedFile: Wrong entry interval.");
+    }
+
+    OpenFile(file_name, is_append);
+
+    // Existing index is keept only if it's not damaged, otherwise it's started again.
+    const std::string index_file_name = LoggerFileIndex::GetIndexFileName(file_name);
+    bool is_index_valid = false;
+    m_index_time_ns = 0;
+    if (is_append) {
+        FILE* index_file = OpenFileUTF8(index_file_name, L"rb");
+        if (index_file) {
+            unsigned char header[LoggerFileIndex::HEADER_SIZE];
+            is_index_valid = fread(header, 1, sizeof(header), index_file) == sizeof(header) && LoggerFileIndex::DecodeHeader(header) &&
+                _fseeki64(index_file, 0, SEEK_END) == 0 && (_ftelli64(index_file) - LoggerFileIndex::HEADER_SIZE) % LoggerFileIndex::RECORD_SIZE == 0;
+
+            // Spans appended to index don't begin before end of last span.
+            unsigned char record[LoggerFileIndex::RECORD_SIZE];
+            if (is_index_valid && _ftelli64(index_file) > LoggerFileIndex::HEADER_SIZE && 
+                    _fseeki64(index_file, -int64_t(sizeof(record)), SEEK_END) == 0 && fread(record, 1, sizeof(record), index_file) == sizeof(record)) {
+                LoggerIndexSpan span = {};
+                LoggerFileIndex::DecodeRecord(record, span);
+                m_index_time_ns = span.end_time_ns;
+            }
+            fclose(index_file);
+        }
+    }
+
+    m_index_file = OpenFileUTF8(index_file_name, is_index_valid ? L"ab" : L"wb");
+    if (!m_index_file) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenIndexedFile: Can not open index file.");
+    }
+    if (!is_index_valid) {
+        unsigned char header[LoggerFileIndex::HEADER_SIZE];
+        LoggerFileIndex::EncodeHeader(header);
+        fwrite(header, 1, sizeof(header), m_index_file);
+    }
+
+    _fseeki64(m_file, 0, SEEK_END);
+    m_index_file_size           = _ftelli64(m_file);
+    m_index_entry_interval      = entry_interval;
+    m_index_time_interval_ns    = int64_t(time_interval_ms) * 1000000;
+    m_index_span                = {};
+}
+
+LOGGER_INLINE bool Logger::IsIndexedFileOpened() const {
+    if (m_output) return m_output->IsIndexedFileOpened();
+
+    return m_file != nullptr && m_index_file != nullptr;
+}
+
+LOGGER_INLINE void Logger::OpenSharedMemory(const std::string& name) {
+    if (m_output) {
+        m_output->OpenSharedMemory(name);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    if (!m_shared_ring.Open(name)) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenSharedMemory: Can not open shared memory.");
+    }
+}
+
+LOGGER_INLINE void Logger::CloseSharedMemory() {
+    if (m_output) {
+        m_output->CloseSharedMemory();
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    m_shared_ring.Close();
+}
+
+LOGGER_INLINE bool Logger::IsSharedMemoryOpened() const {
+    if (m_output) return m_output->IsSharedMemoryOpened();
+
+    return m_shared_ring.IsOpened();
+}
+
+#ifdef LOGGER_USE_SOCKET
+
+LOGGER_INLINE void Logger::OpenSocket(LoggerSocketType type, const std::string& address, LoggerSocketFraming framing, size_t buffer_size, const std::string& app_name) {
+    if (m_output) {
+        m_output->OpenSocket(type, address, framing, buffer_size, app_name);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    if (!m_socket_sink) {
+        m_socket_sink = {new LoggerSocketSink(), [](LoggerSocketSink* socket_sink) { delete socket_sink; }};
+    }
+
+    m_is_socket_opened = false;
+    if (!m_socket_sink->Open(type, address, framing, buffer_size, app_name)) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::OpenSocket: Can not open socket.");
+    }
+    m_is_socket_opened = true;
+}
+
+LOGGER_INLINE void Logger::CloseSocket() {
+    if (m_output) {
+        m_output->CloseSocket();
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    m_is_socket_opened = false;
+    if (m_socket_sink) m_socket_sink->Close();
+}
+
+LOGGER_INLINE bool Logger::IsSocketOpened() const {
+    if (m_output) return m_output->IsSocketOpened();
+
+    return m_is_socket_opened;
+}
+
+LOGGER_INLINE uint64_t Logger::GetSocketSentCount() const {
+    if (m_output) return m_output->GetSocketSentCount();
+
+    return m_socket_sink ? m_socket_sink->GetSentCount() : 0;
+}
+
+LOGGER_INLINE uint64_t Logger::GetSocketDroppedCount() const {
+    if (m_output) return m_output->GetSocketDroppedCount();
+
+    return m_socket_sink ? m_socket_sink->GetDroppedCount() : 0;
+}
+
+#endif
+
+LOGGER_INLINE FILE* Logger::OpenFileUTF8(const std::string& file_name, const wchar_t* mode) {
+    const int size = MultiByteToWideChar(CP_UTF8, 0, file_name.c_str(), -1, NULL, 0);
+    if (size <= 0) return nullptr;
+
+    std::wstring file_name_utf16(size, L'\0');
+    if (MultiByteToWideChar(CP_UTF8, 0, file_name.c_str(), -1, &file_name_utf16[0], size) == 0) return nullptr;
+
+    FILE* file = nullptr;
+    if (_wfopen_s(&file, file_name_utf16.c_str(), mode) != 0) return nullptr;
+    return file;
+}
+
+LOGGER_INLINE void Logger::OpenShardedFiles(const std::string& file_name_prefix) {
+    if (m_output) {
+        m_output->OpenShardedFiles(file_name_prefix);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    CloseFile();
+
+    static std::atomic<uint64_t> s_last_session_id(0);
+
+    std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+
+    m_shard_file_name_prefix = file_name_prefix;
+    m_shard_sequence = 0;
+    m_shard_file_count = 0;
+    m_shard_session_id = ++s_last_session_id;
+
+    ShardSessions& shard_sessions = GetShardSessionsRef();
+    std::lock_guard<std::mutex> sessions_lock(shard_sessions.mutex);
+    shard_sessions.live_ids.insert(m_shard_session_id.load(std::memory_order_relaxed));
+}
+
+LOGGER_INLINE bool Logger::IsShardedFilesOpened() const {
+    if (m_output) return m_output->IsShardedFilesOpened();
+
+    return m_shard_session_id != 0;
+}
+
+LOGGER_INLINE std::vector<std::string> Logger::GetShardFileNames() {
+    if (m_output) return m_output->GetShardFileNames();
+
+    std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+
+    std::vector<std::string> file_names;
+    for (const auto& shard : m_shards) file_names.push_back(shard->file_name);
+    return file_names;
+}
+
+LOGGER_INLINE std::string& Logger::GetThreadNameRef() {
+    thread_local std::string s_thread_name = std::to_string(GetCurrentThreadId());
+    return s_thread_name;
+}
+
+LOGGER_INLINE std::vector<Logger::ThreadShard>& Logger::GetThreadShards() {
+    thread_local std::vector<ThreadShard> s_thread_shards;
+    return s_thread_shards;
+}
+
+LOGGER_INLINE Logger::ShardSessions& Logger::GetShardSessionsRef() {
+    static ShardSessions s_shard_sessions;
+    return s_shard_sessions;
+}
+
+LOGGER_INLINE void Logger::SetThreadName(const std::string& name) {
+    std::string& thread_name = GetThreadNameRef();
+
+    thread_name = name.substr(0, 100);
+    for (char& c : thread_name) {
+        if (c == ' ' || c == '\n' || c == '\t') c = '_';
+    }
+    if (thread_name.empty()) thread_name = std::to_string(GetCurrentThreadId());
+}
+
+LOGGER_INLINE void Logger::WriteToShard(uint64_t session_id, const LoggerSpan* spans, size_t span_count, size_t length) {
+    std::vector<ThreadShard>& thread_shards = GetThreadShards();
+
+    Shard* shard = nullptr;
+    for (const ThreadShard& thread_shard : thread_shards) {
+        if (thread_shard.session_id == session_id) {
+            shard = thread_shard.shard;
+            break;
+        }
+    }
+
+    // First entry of this thread in this session.
+    if (!shard) {
+        // Counter keeps name unique within session, even when thread id is reused.
+        std::string file_name;
+        {
+            std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+            file_name = m_shard_file_name_prefix + "." + std::to_string(GetCurrentThreadId()) 
+                + "." + std::to_string(m_shard_file_count++) + ".shard";
+        }
+
+        FILE* file = OpenFileUTF8(file_name, L"wb");
+        if (!file) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::WriteToShard: Can not open shard file.");
+        }
+        setvbuf(file, NULL, _IOFBF, 64 * 1024);
+
+        std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+
+        m_shards.push_back(std::unique_ptr<Shard>(new Shard{file, file_name}));
+        shard = m_shards.back().get();
+
+        // Drops shards of closed sessions. Sessions of other loggers, which are still open, are kept.
+        {
+            ShardSessions& shard_sessions = GetShardSessionsRef();
+            std::lock_guard<std::mutex> sessions_lock(shard_sessions.mutex);
+
+            for (size_t index = 0; index < thread_shards.size();) {
+                if (shard_sessions.live_ids.count(thread_shards[index].session_id) == 0) {
+                    thread_shards.erase(thread_shards.begin() + index);
+                } else {
+                    ++index;
+                }
+            }
+        }
+        thread_shards.push_back({session_id, shard});
+    }
+
+    const uint64_t sequence = m_shard_sequence.fetch_add(1, std::memory_order_relaxed);
+    const int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+    char header[256];
+    const int header_length = snprintf(header, sizeof(header), "%llu %lld %s %llu\n", 
+        (unsigned long long)sequence, (long long)timestamp, GetThreadNameRef().c_str(), (unsigned long long)length);
+
+    if (header_length < 0 || header_length >= int(sizeof(header)) 
+            || fwrite(header, 1, header_length, shard->file) != size_t(header_length)) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::WriteToShard: Failed write the text to the shard file.");
+    }
+    for (size_t index = 0; index < span_count; ++index) {
+        if (fwrite(spans[index].data, 1, spans[index].length, shard->file) != spans[index].length) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::WriteToShard: Failed write the text to the shard file.");
+        }
+    }
+}
+
+LOGGER_INLINE void Logger::CloseShards() {
+    std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+
+    for (const auto& shard : m_shards) fclose(shard->file);
+    m_shards.clear();
+
+    if (m_shard_session_id != 0) {
+        ShardSessions& shard_sessions = GetShardSessionsRef();
+        std::lock_guard<std::mutex> sessions_lock(shard_sessions.mutex);
+        shard_sessions.live_ids.erase(m_shard_session_id.load(std::memory_order_relaxed));
+    }
+    m_shard_session_id = 0;
+}
+
+LOGGER_INLINE bool Logger::MergeShardFiles(const std::vector<std::string>& shard_file_names, const std::string& output_file_name, bool is_tagged) {
+    struct ShardReader {
+        FILE*           file;
+        uint64_t        sequence;
+        long long       timestamp;
+        char            thread_name[128];
+        std::string     text;
+
+        // Returns false at end of shard.
+        bool ReadRecord(bool& is_error) {
+            char header[256];
+            size_t header_length = 0;
+
+            for (int c = fgetc(file); c != '\n'; c = fgetc(file)) {
+                if (c == EOF && header_length == 0) return false;
+                if (c == EOF || header_length + 1 >= sizeof(header)) {
+                    is_error = true;
+                    return false;
+                }
+                header[header_length++] = char(c);
+            }
+            header[header_length] = '\0';
+
+            // <sequence> <timestamp> <thread name> <length>
+            char* end = nullptr;
+            sequence = strtoull(header, &end, 10);
+            timestamp = strtoll(end, &end, 10);
+
+            const char* name_begin = (*end == ' ') ? end + 1 : end;
+            const char* name_end = strchr(name_begin, ' ');
+            if (!name_end || name_end == name_begin || size_t(name_end - name_begin) >= sizeof(thread_name)) {
+                is_error = true;
+                return false;
+            }
+            memcpy(thread_name, name_begin, name_end - name_begin);
+            thread_name[name_end - name_begin] = '\0';
+
+            const unsigned long long length = strtoull(name_end, &end, 10);
+            if (*end != '\0') {
+                is_error = true;
+                return false;
+            }
+
+            text.resize(size_t(length));
+            if (length > 0 && fread(&text[0], 1, text.length(), file) != text.length()) {
+                is_error = true;
+                return false;
+            }
+            return true;
+        }
+    };
+
+    std::vector<ShardReader> readers(shard_file_names.size());
+    bool is_error = false;
+
+    auto CloseAll = [&readers]() {
+        for (ShardReader& reader : readers) if (reader.file) fclose(reader.file);
+    };
+
+    auto IsLater = [&readers](size_t left, size_t right) { 
+        return readers[left].sequence > readers[right].sequence; 
+    };
+    std::vector<size_t> heap;
+
+    for (size_t index = 0; index < readers.size(); ++index) {
+        readers[index].file = OpenFileUTF8(shard_file_names[index], L"rb");
+        if (!readers[index].file) is_error = true;
+        else if (readers[index].ReadRecord(is_error)) heap.push_back(index);
+    }
+
+    FILE* output = is_error ? nullptr : OpenFileUTF8(output_file_name, L"wb");
+    if (!output) {
+        CloseAll();
+        return false;
+    }
+
+    std::make_heap(heap.begin(), heap.end(), IsLater);
+
+    while (!heap.empty() && !is_error) {
+        std::pop_heap(heap.begin(), heap.end(), IsLater);
+        ShardReader& reader = readers[heap.back()];
+
+        if (is_tagged) {
+            const time_t seconds = time_t(reader.timestamp / 1000000000);
+            tm ti = {};
+            localtime_s(&ti, &seconds);
+
+            fprintf(output, "[%d/%02d/%02d %02d:%02d:%02d.%06d][%s]", 1900 + ti.tm_year, 1 + ti.tm_mon, ti.tm_mday, ti.tm_hour, ti.tm_min, ti.tm_sec, 
+                int((reader.timestamp / 1000) % 1000000), reader.thread_name);
+        }
+        if (fwrite(reader.text.c_str(), 1, reader.text.length(), output) != reader.text.length()) is_error = true;
+
+        if (reader.ReadRecord(is_error)) {
+            std::push_heap(heap.begin(), heap.end(), IsLater);
+        } else {
+            heap.pop_back();
+        }
+    }
+
+    fclose(output);
+    CloseAll();
+    return !is_error;
+}
+
+LOGGER_INLINE void Logger::CompressBlocks() {
+    std::string frame;
+
+    while (true) {
+        std::string block;
+        {
+            std::unique_lock<std::mutex> compress_lock(m_compress_mutex);
+            m_compress_condition.wait(compress_lock, [this]() { return !m_compress_queue.empty() || m_is_compress_stop; });
+
+            if (m_compress_queue.empty()) break;
+
+            block.swap(m_compress_queue.front());
+            m_compress_queue.pop_front();
+        }
+
+        // Failure is reported to logging thread by WriteFileBatch and WaitForCompressedBlocks, remaining blocks are dropped.
+        bool is_failed = false;
+        {
+            std::lock_guard<std::mutex> compress_lock(m_compress_mutex);
+            is_failed = m_is_compress_failed;
+        }
+        if (!is_failed) {
+            frame.clear();
+            LoggerBlockCodec::AppendFrame(frame, m_compression, block.c_str(), block.length());
+
+            const LoggerSpan span = {frame.c_str(), frame.length()};
+            is_failed = !TryWriteToFile(&span, 1);
+        }
+        m_compress_pending_bytes.fetch_sub(block.length(), std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> compress_lock(m_compress_mutex);
+            --m_compress_pending_count;
+            if (is_failed) m_is_compress_failed = true;
+        }
+        m_compress_condition.notify_all();
+    }
+}
+
+LOGGER_INLINE void Logger::WaitForCompressedBlocks() {
+    if (m_output) {
+        m_output->WaitForCompressedBlocks();
+    } else if (m_is_compressed) {
+        std::unique_lock<std::mutex> compress_lock(m_compress_mutex);
+        m_compress_condition.wait(compress_lock, [this]() { return m_compress_pending_count == 0; });
+
+        if (m_is_compress_failed) {
+            compress_lock.unlock();
+            TOSTR_INNER_FATAL_ERROR("Error Logger::Flush: Failed write the compressed block to the log file.");
+        }
+    }
+}
+
+LOGGER_INLINE void Logger::SetFileBatchSize(size_t batch_size) {
+    if (m_output) {
+        m_output->SetFileBatchSize(batch_size);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    Flush();
+    m_file_batch_size = batch_size;
+    m_file_batch.clear();
+    m_file_batch.shrink_to_fit();
+    m_file_batch.reserve(batch_size);
+}
+
+LOGGER_INLINE size_t Logger::GetFileBatchSize() const {
+    if (m_output) return m_output->GetFileBatchSize();
+
+    return m_file_batch_size;
+}
+
+LOGGER_INLINE void Logger::Flush() {
+    if (m_output) {
+        m_output->Flush();
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+#ifdef LOGGER_USE_SOCKET
+    if (m_is_socket_opened) m_socket_sink->Flush();
+#endif
+    if (m_console_sink.IsOpened()) m_console_sink.Flush();
+
+    if (m_shard_session_id != 0) {
+        std::lock_guard<std::mutex> shard_lock(m_shard_mutex);
+        for (const auto& shard : m_shards) fflush(shard->file);
+    }
+
+    if (m_index_file) fflush(m_index_file);
+
+    WriteFileBatch();
+    WaitForCompressedBlocks();
+}
+
+LOGGER_INLINE void Logger::WriteFileBatch() {
+    if (m_file && !m_file_batch.empty()) {
+        if (m_is_compressed) {
+            {
+                // Logging thread waits when too many blocks are queued, so queue doesn't grow without limit.
+                std::unique_lock<std::mutex> compress_lock(m_compress_mutex);
+                m_compress_condition.wait(compress_lock, [this]() { return m_compress_pending_count < MAX_COMPRESS_PENDING_COUNT; });
+
+                if (m_is_compress_failed) {
+                    compress_lock.unlock();
+                    TOSTR_INNER_FATAL_ERROR("Error Logger::Flush: Failed write the compressed block to the log file.");
+                }
+
+                m_compress_pending_bytes.fetch_add(m_file_batch.length(), std::memory_order_relaxed);
+                m_compress_queue.push_back(std::string());
+                m_compress_queue.back().swap(m_file_batch);
+                ++m_compress_pending_count;
+            }
+            m_compress_condition.notify_all();
+
+            m_file_batch.reserve(m_file_batch_size);
+        } else {
+            WriteToFile(m_file_batch.c_str(), m_file_batch.length());
+            m_file_batch.clear();
+        }
+    }
+}
+
+LOGGER_INLINE void Logger::OpenStdOut() {
+    if (m_output) {
+        m_output->OpenStdOut();
+        return;
+    }
+
+    m_is_stdout = true;
+}
+
+LOGGER_INLINE void Logger::CloseStdOut() {
+    if (m_output) {
+        m_output->CloseStdOut();
+        return;
+    }
+
+    m_is_stdout = false;
+}
+
+LOGGER_INLINE bool Logger::IsStdOutOpened() const {
+    if (m_output) return m_output->IsStdOutOpened();
+
+    return m_is_stdout; 
+}
+
+LOGGER_INLINE void Logger::OpenAsyncStdOut(size_t buffer_size, bool is_colored) {
+    if (m_output) {
+        m_output->OpenAsyncStdOut(buffer_size, is_colored);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    m_console_sink.Open(buffer_size, is_colored);
+}
+
+LOGGER_INLINE void Logger::CloseAsyncStdOut() {
+    if (m_output) {
+        m_output->CloseAsyncStdOut();
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    m_console_sink.Close();
+}
+
+LOGGER_INLINE bool Logger::IsAsyncStdOutOpened() const {
+    if (m_output) return m_output->IsAsyncStdOutOpened();
+
+    return m_console_sink.IsOpened();
+}
+
+LOGGER_INLINE uint64_t Logger::GetAsyncStdOutDroppedCount() const {
+    if (m_output) return m_output->GetAsyncStdOutDroppedCount();
+
+    return m_console_sink.GetDroppedCount();
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void Logger::SetDoAtFatalError(DoAtFatalErrorFnP_T do_at_fatal_error) { 
+    m_do_at_fatal_error = do_at_fatal_error; 
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void Logger::Enable(LoggerOption option) {
+    SetOption(option, true);
+}
+LOGGER_INLINE void Logger::Disable(LoggerOption option) {
+    SetOption(option, false);
+}
+
+LOGGER_INLINE void Logger::SetOption(LoggerOption option, bool is) {
+    switch (option) {
+        case LoggerOption::LOG_TIME:        m_is_log_time       = is; break;
+        case LoggerOption::LOG_TRACE:       m_is_log_trace      = is; break;
+        case LoggerOption::LOG_DUMP:        m_is_log_dump       = is; break;
+        case LoggerOption::LOG_EVENT:       m_is_log_event      = is; break;
+        case LoggerOption::LOG_WARNING:     m_is_log_warning    = is; break;
+        case LoggerOption::SANITIZE_UTF8:   m_is_sanitize_utf8  = is; break;
+        case LoggerOption::COLLECT_STATS:   m_is_collect_stats  = is; break;
+    }
+}
+
+LOGGER_INLINE void Logger::SetMinSeverity(int min_severity) {
+    m_min_severity = min_severity;
+}
+
+LOGGER_INLINE int Logger::GetMinSeverity() const {
+    return m_min_severity;
+}
+
+LOGGER_INLINE std::atomic<size_t>& Logger::GetCategoryCountRef() {
+    static std::atomic<size_t> s_category_count(0);
+    return s_category_count;
+}
+
+LOGGER_INLINE const std::string& Logger::GetName() const {
+    return m_name;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerStats Logger::GetStats() const {
+    LoggerStats stats = {};
+
+    LoggerCategoryStats* categories[STATS_COUNT] = {
+        &stats.text, &stats.trace, &stats.dump, &stats.event, &stats.warning, &stats.error, &stats.fatal_error, &stats.custom
+    };
+    for (size_t index = 0; index < STATS_COUNT; ++index) {
+        categories[index]->entry_count  = m_stats_categories[index].entry_count.load(std::memory_order_relaxed);
+        categories[index]->byte_count   = m_stats_categories[index].byte_count.load(std::memory_order_relaxed);
+    }
+
+    stats.suppressed_count  = m_stats_suppressed_count.load(std::memory_order_relaxed);
+    stats.shed_count        = m_stats_shed_count.load(std::memory_order_relaxed);
+    stats.dropped_count     = m_stats_dropped_count.load(std::memory_order_relaxed);
+    stats.format_time_ns    = m_stats_format_time_ns.load(std::memory_order_relaxed);
+
+    const Logger& output = m_output ? *m_output : *this;
+
+    stats.flush_count       = output.m_stats_flush_count.load(std::memory_order_relaxed);
+    stats.write_time_ns     = output.m_stats_write_time_ns.load(std::memory_order_relaxed);
+    stats.max_batch_length  = output.m_stats_max_batch_length.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+LOGGER_INLINE void Logger::ResetStats() {
+    for (auto& category : m_stats_categories) {
+        category.entry_count    = 0;
+        category.byte_count     = 0;
+    }
+    m_stats_suppressed_count    = 0;
+    m_stats_shed_count          = 0;
+    m_stats_dropped_count       = 0;
+    m_stats_flush_count         = 0;
+    m_stats_format_time_ns      = 0;
+    m_stats_write_time_ns       = 0;
+    m_stats_max_batch_length    = 0;
+}
+
+LOGGER_INLINE void Logger::SetStatsInterval(unsigned interval_ms) {
+    const int64_t interval_ns = int64_t(interval_ms) * 1000000;
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    m_stats_interval_ns         = interval_ns;
+    m_stats_next_log_time_ns    = now_ns + interval_ns;
+}
+
+LOGGER_INLINE void Logger::SetHexDumpLimit(size_t limit) {
+    m_hex_dump_limit = limit;
+}
+
+LOGGER_INLINE size_t Logger::GetHexDumpLimit() const {
+    return m_hex_dump_limit;
+}
+
+LOGGER_INLINE void Logger::SetBudget(size_t bytes_per_second, size_t memory_bytes) {
+    Logger& output = m_output ? *m_output : *this;
+
+    output.m_budget_memory_bytes        = memory_bytes;
+    output.m_budget_window_begin_ns     = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    output.m_budget_window_bytes        = 0;
+    output.m_budget_bytes_per_second    = bytes_per_second;
+}
+
+LOGGER_INLINE bool Logger::IsShedByBudget(Logger& output, int severity) {
+    const uint64_t budget_bytes_per_second = output.m_budget_bytes_per_second.load(std::memory_order_relaxed);
+    if (budget_bytes_per_second == 0) return false;
+
+    output.UpdateBudgetWindow();
+
+    // Used part of budget in quarters.
+    uint64_t usage = output.m_budget_window_bytes.load(std::memory_order_relaxed) * 4 / budget_bytes_per_second;
+
+    const uint64_t budget_memory_bytes = output.m_budget_memory_bytes.load(std::memory_order_relaxed);
+    if (budget_memory_bytes != 0) {
+        const uint64_t memory_usage = output.m_compress_pending_bytes.load(std::memory_order_relaxed) * 4 / budget_memory_bytes;
+        if (memory_usage > usage) usage = memory_usage;
+    }
+
+    ShedIndex shed_index;
+    if (severity < LoggerCategory::Dump::SEVERITY) {
+        if (usage < 2) return false;
+        shed_index = SHED_TRACE;
+    } else if (severity < LoggerCategory::Event::SEVERITY) {
+        if (usage < 3) return false;
+        shed_index = SHED_DUMP;
+    } else {
+        if (usage < 4) return false;
+        shed_index = SHED_EVENT;
+    }
+
+    output.m_budget_shed_counts[shed_index].fetch_add(1, std::memory_order_relaxed);
+    if (m_is_collect_stats) m_stats_shed_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+LOGGER_INLINE void Logger::UpdateBudgetWindow() {
+    // Budget is counted in windows of one second. Thread which starts new window logs summary of previous one.
+    const int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t window_begin_ns = m_budget_window_begin_ns.load(std::memory_order_relaxed);
+    if (now_ns - window_begin_ns >= 1000000000 && m_budget_window_begin_ns.compare_exchange_strong(window_begin_ns, now_ns, std::memory_order_relaxed)) {
+        m_budget_window_bytes.store(0, std::memory_order_relaxed);
+        LogBudgetSummary();
+    }
+}
+
+LOGGER_INLINE void Logger::LogBudgetSummary() {
+    uint64_t shed_counts[SHED_COUNT];
+    uint64_t total_shed_count = 0;
+    for (size_t index = 0; index < SHED_COUNT; ++index) {
+        shed_counts[index] = m_budget_shed_counts[index].exchange(0, std::memory_order_relaxed);
+        total_shed_count += shed_counts[index];
+    }
+    if (total_shed_count == 0) return;
+
+    OutputText(GenerateEntryPrefix<Budget>() + GenerateMessage("Shed entries: trace %llu, dump %llu, event %llu.\n", 
+        (unsigned long long)shed_counts[SHED_TRACE], 
+        (unsigned long long)shed_counts[SHED_DUMP], 
+        (unsigned long long)shed_counts[SHED_EVENT]
+    ), Budget::SEVERITY);
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE size_t Logger::RegisterMetric(const std::string& name, LoggerMetricType type) {
+    std::lock_guard<std::mutex> metric_lock(m_metric_mutex);
+
+    for (size_t index = 0; index < m_metrics.size(); ++index) {
+        if (m_metrics[index]->name == name) {
+            if (m_metrics[index]->type != type) {
+                TOSTR_INNER_FATAL_ERROR("Error Logger::RegisterMetric: Metric of same name and other type is already registered.");
+            }
+            return index;
+        }
+    }
+
+    m_metrics.push_back(std::unique_ptr<Metric>(new Metric()));
+    m_metrics.back()->name  = name;
+    m_metrics.back()->type  = type;
+    m_metrics.back()->last  = 0;
+    m_metrics.back()->exited_accumulator = nullptr;
+
+    return m_metrics.size() - 1;
+}
+
+LOGGER_INLINE void Logger::RecordMetric(size_t metric_index, int64_t value) {
+    MetricAccumulator& accumulator = GetThreadMetricAccumulator(metric_index);
+    const LoggerMetricType type = accumulator.metric->type;
+
+    // Accumulator has only one writer, so it's updated without read-modify-write, 
+    // except min and max, which are also reset by FlushMetrics.
+    accumulator.sum.store(accumulator.sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+
+    if (type != LoggerMetricType::COUNTER) {
+        int64_t min = accumulator.min.load(std::memory_order_relaxed);
+        while (value < min && !accumulator.min.compare_exchange_weak(min, value, std::memory_order_relaxed)) {}
+
+        int64_t max = accumulator.max.load(std::memory_order_relaxed);
+        while (value > max && !accumulator.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    if (type == LoggerMetricType::GAUGE) {
+        accumulator.metric->last.store(value, std::memory_order_relaxed);
+    } else if (type == LoggerMetricType::HISTOGRAM) {
+        std::atomic<uint64_t>& bucket = accumulator.buckets[GetMetricBucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Count is stored last, so FlushMetrics sees other values of counted samples.
+    accumulator.count.store(accumulator.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+LOGGER_INLINE void Logger::SetMetricInterval(unsigned interval_ms) {
+    StopMetricTick();
+
+    if (interval_ms > 0) {
+        m_metric_interval_ms    = interval_ms;
+        m_is_metric_tick_stop   = false;
+        m_metric_thread         = std::thread(&Logger::TickMetrics, this);
+    }
+}
+
+LOGGER_INLINE void Logger::FlushMetrics() {
+    std::vector<std::string> entries;
+    {
+        std::lock_guard<std::mutex> metric_lock(m_metric_mutex);
+
+        for (const auto& metric : m_metrics) {
+            const bool is_histogram = metric->type == LoggerMetricType::HISTOGRAM;
+
+            uint64_t                count   = 0;
+            int64_t                 sum     = 0;
+            int64_t                 min     = INT64_MAX;
+            int64_t                 max     = INT64_MIN;
+            std::vector<uint64_t>   buckets(is_histogram ? METRIC_BUCKET_COUNT : 0, 0);
+            uint64_t                sample_count = 0;
+
+            for (const auto& accumulator : metric->accumulators) {
+                const uint64_t accumulator_count = accumulator->count.load(std::memory_order_acquire);
+                if (accumulator_count == accumulator->flushed_count) continue;
+
+                count += accumulator_count - accumulator->flushed_count;
+                accumulator->flushed_count = accumulator_count;
+
+                const int64_t accumulator_sum = accumulator->sum.load(std::memory_order_relaxed);
+                sum += accumulator_sum - accumulator->flushed_sum;
+                accumulator->flushed_sum = accumulator_sum;
+
+                min = std::min(min, accumulator->min.exchange(INT64_MAX, std::memory_order_relaxed));
+                max = std::max(max, accumulator->max.exchange(INT64_MIN, std::memory_order_relaxed));
+
+                if (is_histogram) {
+                    for (size_t index = 0; index < METRIC_BUCKET_COUNT; ++index) {
+                        const uint64_t bucket = accumulator->buckets[index].load(std::memory_order_relaxed);
+                        buckets[index] += bucket - accumulator->flushed_buckets[index];
+                        sample_count += bucket - accumulator->flushed_buckets[index];
+                        accumulator->flushed_buckets[index] = bucket;
+                    }
+                }
+            }
+            if (count == 0) continue;
+
+            // Sample recorded during previous flush can have min and max taken by it and be counted by this one.
+            if (min > max) min = max = sum / int64_t(count);
+
+            switch (metric->type) {
+            case LoggerMetricType::COUNTER:
+                entries.push_back(GenerateMessage("%s (counter): count %llu, sum %lld.\n", 
+                    metric->name.c_str(), (unsigned long long)count, (long long)sum));
+                break;
+            case LoggerMetricType::GAUGE:
+                entries.push_back(GenerateMessage("%s (gauge): count %llu, last %lld, min %lld, max %lld.\n", 
+                    metric->name.c_str(), (unsigned long long)count, (long long)metric->last.load(std::memory_order_relaxed), (long long)min, (long long)max));
+                break;
+            case LoggerMetricType::HISTOGRAM:
+                entries.push_back(GenerateMessage("%s (histogram): count %llu, sum %lld, min %lld, max %lld, p50 %lld, p90 %lld, p99 %lld.\n", 
+                    metric->name.c_str(), (unsigned long long)count, (long long)sum, (long long)min, (long long)max,
+                    (long long)GetMetricPercentile(buckets, sample_count, 50, min, max),
+                    (long long)GetMetricPercentile(buckets, sample_count, 90, min, max),
+                    (long long)GetMetricPercentile(buckets, sample_count, 99, min, max)));
+                break;
+            }
+        }
+    }
+
+    for (const std::string& entry : entries) {
+        OutputText(GenerateEntryPrefix<Metrics>() + entry, Metrics::SEVERITY);
+    }
+}
+
+LOGGER_INLINE Logger::MetricAccumulator& Logger::GetThreadMetricAccumulator(size_t metric_index) {
+    std::vector<ThreadMetrics>& thread_metrics_list = GetThreadMetricsRef();
+
+    ThreadMetrics* thread_metrics = nullptr;
+    for (ThreadMetrics& element : thread_metrics_list) {
+        if (element.session_id == m_metric_session_id) {
+            thread_metrics = &element;
+            break;
+        }
+    }
+    if (!thread_metrics) {
+        // Drops accumulators of destroyed loggers.
+        {
+            MetricSessions& metric_sessions = GetMetricSessionsRef();
+            std::lock_guard<std::mutex> sessions_lock(metric_sessions.mutex);
+
+            for (size_t index = 0; index < thread_metrics_list.size();) {
+                if (metric_sessions.loggers.count(thread_metrics_list[index].session_id) == 0) {
+                    thread_metrics_list.erase(thread_metrics_list.begin() + index);
+                } else {
+                    ++index;
+                }
+            }
+        }
+        thread_metrics_list.push_back({m_metric_session_id, {}});
+        thread_metrics = &thread_metrics_list.back();
+    }
+
+    if (metric_index < thread_metrics->accumulators.size() && thread_metrics->accumulators[metric_index]) {
+        return *thread_metrics->accumulators[metric_index];
+    }
+
+    // First value of metric recorded by this thread.
+    std::lock_guard<std::mutex> metric_lock(m_metric_mutex);
+
+    if (metric_index >= m_metrics.size()) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::RecordMetric: Metric is not registered.");
+    }
+    MetricAccumulator& accumulator = AddMetricAccumulator(*m_metrics[metric_index]);
+
+    if (metric_index >= thread_metrics->accumulators.size()) thread_metrics->accumulators.resize(metric_index + 1, nullptr);
+    thread_metrics->accumulators[metric_index] = &accumulator;
+
+    return accumulator;
+}
+
+LOGGER_INLINE Logger::MetricAccumulator& Logger::AddMetricAccumulator(Metric& metric) {
+    metric.accumulators.push_back(std::unique_ptr<MetricAccumulator>(new MetricAccumulator()));
+    MetricAccumulator& accumulator = *metric.accumulators.back();
+
+    accumulator.metric          = &metric;
+    accumulator.count           = 0;
+    accumulator.sum             = 0;
+    accumulator.min             = INT64_MAX;
+    accumulator.max             = INT64_MIN;
+    accumulator.flushed_count   = 0;
+    accumulator.flushed_sum     = 0;
+    if (metric.type == LoggerMetricType::HISTOGRAM) {
+        accumulator.buckets.reset(new std::atomic<uint64_t>[METRIC_BUCKET_COUNT]());
+        accumulator.flushed_buckets.reset(new uint64_t[METRIC_BUCKET_COUNT]());
+    }
+    return accumulator;
+}
+
+LOGGER_INLINE void Logger::FoldThreadMetrics(ThreadMetrics& thread_metrics) {
+    std::lock_guard<std::mutex> metric_lock(m_metric_mutex);
+
+    for (MetricAccumulator* accumulator : thread_metrics.accumulators) {
+        if (!accumulator) continue;
+        Metric& metric = *accumulator->metric;
+
+        // Values not flushed yet are added to accumulator of exited threads, which is read by FlushMetrics as any other.
+        if (!metric.exited_accumulator) metric.exited_accumulator = &AddMetricAccumulator(metric);
+        MetricAccumulator& exited = *metric.exited_accumulator;
+
+        exited.count.store(exited.count.load(std::memory_order_relaxed) + accumulator->count.load(std::memory_order_relaxed) - accumulator->flushed_count, std::memory_order_relaxed);
+        exited.sum.store(exited.sum.load(std::memory_order_relaxed) + accumulator->sum.load(std::memory_order_relaxed) - accumulator->flushed_sum, std::memory_order_relaxed);
+        exited.min.store(std::min(exited.min.load(std::memory_order_relaxed), accumulator->min.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        exited.max.store(std::max(exited.max.load(std::memory_order_relaxed), accumulator->max.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        if (metric.type == LoggerMetricType::HISTOGRAM) {
+            for (size_t index = 0; index < METRIC_BUCKET_COUNT; ++index) {
+                const uint64_t bucket = accumulator->buckets[index].load(std::memory_order_relaxed);
+                exited.buckets[index].store(exited.buckets[index].load(std::memory_order_relaxed) + bucket - accumulator->flushed_buckets[index], std::memory_order_relaxed);
+            }
+        }
+
+        for (size_t index = 0; index < metric.accumulators.size(); ++index) {
+            if (metric.accumulators[index].get() == accumulator) {
+                metric.accumulators.erase(metric.accumulators.begin() + index);
+                break;
+            }
+        }
+    }
+    thread_metrics.accumulators.clear();
+}
+
+LOGGER_INLINE Logger::ThreadMetricsList::~ThreadMetricsList() {
+    MetricSessions& metric_sessions = GetMetricSessionsRef();
+    std::lock_guard<std::mutex> sessions_lock(metric_sessions.mutex);
+
+    for (ThreadMetrics& thread_metrics : elements) {
+        auto it = metric_sessions.loggers.find(thread_metrics.session_id);
+        if (it != metric_sessions.loggers.end()) it->second->FoldThreadMetrics(thread_metrics);
+    }
+}
+
+LOGGER_INLINE void Logger::TickMetrics() {
+    std::unique_lock<std::mutex> tick_lock(m_metric_tick_mutex);
+
+    auto next_time = std::chrono::steady_clock::now();
+    while (true) {
+        next_time += std::chrono::milliseconds(m_metric_interval_ms);
+        if (m_metric_tick_condition.wait_until(tick_lock, next_time, [this]() { return m_is_metric_tick_stop; })) break;
+
+        tick_lock.unlock();
+        FlushMetrics();
+        tick_lock.lock();
+    }
+}
+
+LOGGER_INLINE void Logger::StopMetricTick() {
+    if (m_metric_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> tick_lock(m_metric_tick_mutex);
+            m_is_metric_tick_stop = true;
+        }
+        m_metric_tick_condition.notify_all();
+        m_metric_thread.join();
+    }
+}
+
+LOGGER_INLINE size_t Logger::RegisterDumpProvider(const std::string& name, unsigned interval_ms, std::function<void (std::string& text)> provider) {
+    if (interval_ms == 0) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::RegisterDumpProvider: Interval must be at least 1 ms.");
+    }
+
+    std::lock_guard<std::mutex> dump_provider_lock(m_dump_provider_mutex);
+
+    const std::chrono::milliseconds interval(interval_ms);
+    m_dump_providers.push_back({++m_last_dump_provider_id, name, interval, std::move(provider), std::chrono::steady_clock::now() + interval});
+
+    if (!m_dump_provider_thread.joinable()) {
+        m_is_dump_provider_stop = false;
+        m_dump_provider_thread  = std::thread(&Logger::RunDumpProviders, this);
+    }
+    m_is_dump_provider_changed = true;
+    m_dump_provider_condition.notify_all();
+
+    return m_last_dump_provider_id;
+}
+
+LOGGER_INLINE void Logger::UnregisterDumpProvider(size_t provider_id) {
+    // Provider is called with locked mutex, so after unregistering it isn't running either.
+    std::lock_guard<std::mutex> dump_provider_lock(m_dump_provider_mutex);
+
+    for (size_t index = 0; index < m_dump_providers.size(); ++index) {
+        if (m_dump_providers[index].id == provider_id) {
+            m_dump_providers.erase(m_dump_providers.begin() + index);
+            break;
+        }
+    }
+    m_is_dump_provider_changed = true;
+    m_dump_provider_condition.notify_all();
+}
+
+LOGGER_INLINE void Logger::FlushDumpProviders() {
+    std::lock_guard<std::mutex> dump_provider_lock(m_dump_provider_mutex);
+
+    LogDumpProviders(true, std::chrono::steady_clock::now());
+}
+
+LOGGER_INLINE void Logger::RunDumpProviders() {
+    std::unique_lock<std::mutex> dump_provider_lock(m_dump_provider_mutex);
+
+    while (true) {
+        const auto IsWakeUp = [this]() { return m_is_dump_provider_stop || m_is_dump_provider_changed; };
+
+        if (m_dump_providers.empty()) {
+            m_dump_provider_condition.wait(dump_provider_lock, IsWakeUp);
+        } else {
+            auto next_time = m_dump_providers.front().next_time;
+            for (const DumpProvider& provider : m_dump_providers) next_time = std::min(next_time, provider.next_time);
+
+            m_dump_provider_condition.wait_until(dump_provider_lock, next_time, IsWakeUp);
+        }
+        if (m_is_dump_provider_stop) break;
+        m_is_dump_provider_changed = false;
+
+        LogDumpProviders(false, std::chrono::steady_clock::now());
+    }
+}
+
+LOGGER_INLINE void Logger::StopDumpProviders() {
+    if (m_dump_provider_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> dump_provider_lock(m_dump_provider_mutex);
+            m_is_dump_provider_stop = true;
+        }
+        m_dump_provider_condition.notify_all();
+        m_dump_provider_thread.join();
+    }
+}
+
+LOGGER_INLINE void Logger::LogDumpProviders(bool is_all, std::chrono::steady_clock::time_point now) {
+    std::vector<DumpProvider*> due_providers;
+    for (DumpProvider& provider : m_dump_providers) {
+        if (!is_all && provider.next_time > now) continue;
+        due_providers.push_back(&provider);
+
+        // Calls which were missed (for example when providers took too long) aren't made up.
+        provider.next_time += provider.interval;
+        if (provider.next_time <= now) provider.next_time = now + provider.interval;
+    }
+    if (due_providers.empty()) return;
+
+    // Disabled dumps are skipped before calling any provider.
+    if (!IsEnabled<LoggerCategory::Dump>()) {
+        for (size_t index = 0; index < due_providers.size(); ++index) CountSuppressed();
+        return;
+    }
+
+    // Each provider gives own entry. Entries are generated before output is locked, so providers don't delay logging threads.
+    std::vector<std::string> entries;
+    for (DumpProvider* provider : due_providers) {
+        if (IsShed(LoggerCategory::Dump::SEVERITY)) continue;
+
+        const bool is_collect_stats = m_is_collect_stats;
+        const auto begin = is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        std::string entry = GenerateEntryPrefix<LoggerCategory::Dump>();
+        entry += provider->name;
+        entry += ": ";
+        provider->function(entry);
+        entry += '\n';
+
+        if (is_collect_stats) CountEntry(STATS_DUMP, entry.length(), begin);
+        entries.push_back(std::move(entry));
+    }
+
+    // Entries of one call are output together, without entries of other threads between them.
+    {
+        Logger& output = m_output ? *m_output : *this;
+        std::lock_guard<std::recursive_mutex> lock(output.m_output_mutex);
+
+        for (const std::string& entry : entries) OutputText(entry, LoggerCategory::Dump::SEVERITY);
+    }
+
+    if (m_is_collect_stats) LogStatsIfDue(std::chrono::steady_clock::now());
+}
+
+LOGGER_INLINE std::vector<Logger::ThreadMetrics>& Logger::GetThreadMetricsRef() {
+    thread_local ThreadMetricsList s_thread_metrics;
+    return s_thread_metrics.elements;
+}
+
+LOGGER_INLINE Logger::MetricSessions& Logger::GetMetricSessionsRef() {
+    static MetricSessions s_metric_sessions;
+    return s_metric_sessions;
+}
+
+LOGGER_INLINE size_t Logger::GetMetricBucketIndex(int64_t value) {
+    if (value < METRIC_EXACT_BUCKET_COUNT) return value < 0 ? 0 : size_t(value);
+
+    // Position of highest set bit, at least 3.
+    uint64_t rest = uint64_t(value);
+    size_t bit = 0;
+    for (size_t shift = 32; shift > 0; shift /= 2) {
+        if (rest >> shift) {
+            rest >>= shift;
+            bit += shift;
+        }
+    }
+
+    return METRIC_EXACT_BUCKET_COUNT + (bit - 3) * 8 + ((uint64_t(value) >> (bit - 3)) & 7);
+}
+
+LOGGER_INLINE int64_t Logger::GetMetricBucketValue(size_t bucket_index) {
+    if (bucket_index < METRIC_EXACT_BUCKET_COUNT) return int64_t(bucket_index);
+
+    const size_t shift = (bucket_index - METRIC_EXACT_BUCKET_COUNT) / 8;
+    const uint64_t lower = uint64_t(8 + (bucket_index - METRIC_EXACT_BUCKET_COUNT) % 8) << shift;
+
+    return int64_t(lower + ((uint64_t(1) << shift) / 2));
+}
+
+LOGGER_INLINE int64_t Logger::GetMetricPercentile(const std::vector<uint64_t>& buckets, uint64_t sample_count, unsigned percent, int64_t min, int64_t max) {
+    const uint64_t rank = (sample_count * percent + 99) / 100;
+
+    uint64_t cumulative_count = 0;
+    for (size_t index = 0; index < buckets.size(); ++index) {
+        cumulative_count += buckets[index];
+        if (cumulative_count >= rank && cumulative_count > 0) {
+            return std::min(std::max(GetMetricBucketValue(index), min), max);
+        }
+    }
+    return max;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void Logger::CountEntry(StatsIndex stats_index, size_t length, std::chrono::steady_clock::time_point begin) {
+    const auto now = std::chrono::steady_clock::now();
+
+    m_stats_categories[stats_index].entry_count.fetch_add(1, std::memory_order_relaxed);
+    m_stats_categories[stats_index].byte_count.fetch_add(length, std::memory_order_relaxed);
+    m_stats_format_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin).count(), std::memory_order_relaxed);
+}
+
+LOGGER_INLINE void Logger::LogStatsIfDue(std::chrono::steady_clock::time_point now) {
+    const int64_t interval_ns = m_stats_interval_ns.load(std::memory_order_relaxed);
+    if (interval_ns <= 0) return;
+
+    const int64_t now_ns        = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    int64_t next_log_time_ns    = m_stats_next_log_time_ns.load(std::memory_order_relaxed);
+
+    // Only one thread logs summary for given interval.
+    if (now_ns < next_log_time_ns || !m_stats_next_log_time_ns.compare_exchange_strong(next_log_time_ns, now_ns + interval_ns, std::memory_order_relaxed)) return;
+
+    const LoggerStats stats = GetStats();
+
+    uint64_t entry_count = 0;
+    uint64_t byte_count = 0;
+    for (const LoggerCategoryStats& category : {stats.text, stats.trace, stats.dump, stats.event, stats.warning, stats.error, stats.fatal_error, stats.custom}) {
+        entry_count += category.entry_count;
+        byte_count  += category.byte_count;
+    }
+
+    OutputText(GenerateEntryPrefix<Stats>() + GenerateMessage(
+        "entries: %llu, bytes: %llu, suppressed: %llu, dropped: %llu, flushes: %llu, format time: %.3f ms, write time: %.3f ms, max batch: %llu.\n",
+        (unsigned long long)entry_count, 
+        (unsigned long long)byte_count, 
+        (unsigned long long)stats.suppressed_count, 
+        (unsigned long long)stats.dropped_count, 
+        (unsigned long long)stats.flush_count, 
+        stats.format_time_ns / 1e6, 
+        stats.write_time_ns / 1e6, 
+        (unsigned long long)stats.max_batch_length
+    ), Stats::SEVERITY);
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void Logger::LogText(const std::string& text) {
+    LogBuffer(text.c_str(), text.length());
+}
+
+LOGGER_INLINE void Logger::LogBuffer(const char* text, size_t length) {
+    const LoggerSpan span = {text, length};
+    LogSpans(&span, 1);
+}
+
+LOGGER_INLINE void Logger::LogSpans(const LoggerSpan* spans, size_t span_count) {
+    if (m_is_collect_stats) {
+        size_t length = 0;
+        for (size_t index = 0; index < span_count; ++index) length += spans[index].length;
+
+        m_stats_categories[STATS_TEXT].entry_count.fetch_add(1, std::memory_order_relaxed);
+        m_stats_categories[STATS_TEXT].byte_count.fetch_add(length, std::memory_order_relaxed);
+    }
+    OutputSpans(spans, span_count, LoggerCategory::Event::SEVERITY);
+}
+
+LOGGER_INLINE void Logger::LogSpans(std::initializer_list<LoggerSpan> spans) {
+    LogSpans(spans.begin(), spans.size());
+}
+
+LOGGER_INLINE void Logger::OutputText(const std::string& text, int severity) {
+    const LoggerSpan span = {text.c_str(), text.length()};
+    OutputSpans(&span, 1, severity);
+}
+
+LOGGER_INLINE void Logger::OutputSpans(const LoggerSpan* spans, size_t span_count, int severity) {
+    Logger& output = m_output ? *m_output : *this;
+    if (output.m_budget_bytes_per_second.load(std::memory_order_relaxed) != 0) {
+        // Entries of any severity roll window over, so summary isn't held back until next entry which can be shed.
+        output.UpdateBudgetWindow();
+
+        size_t length = 0;
+        for (size_t index = 0; index < span_count; ++index) length += spans[index].length;
+
+        output.m_budget_window_bytes.fetch_add(length, std::memory_order_relaxed);
+    }
+
+    if (m_is_sanitize_utf8) {
+        // Spans are checked one by one. Sequence split between spans is seen as invalid, so then joined text is checked.
+        bool is_valid = true;
+        for (size_t index = 0; index < span_count && is_valid; ++index) {
+            is_valid = FindInvalidUTF8(spans[index].data, spans[index].length) == spans[index].length;
+        }
+
+        if (!is_valid) {
+            std::string sanitized;
+            for (size_t index = 0; index < span_count; ++index) sanitized.append(spans[index].data, spans[index].length);
+            SanitizeUTF8(sanitized);
+            WriteText(sanitized, severity);
+            return;
+        }
+    }
+    WriteSpans(spans, span_count, severity);
+}
+
+LOGGER_INLINE void Logger::WriteText(const std::string& text, int severity) {
+    const LoggerSpan span = {text.c_str(), text.length()};
+    WriteSpans(&span, 1, severity);
+}
+
+LOGGER_INLINE void Logger::WriteSpans(const LoggerSpan* spans, size_t span_count, int severity) {
+    if (m_output) {
+        m_output->WriteSpans(spans, span_count, severity);
+        return;
+    }
+
+    size_t length = 0;
+    for (size_t index = 0; index < span_count; ++index) length += spans[index].length;
+
+    const uint64_t shard_session_id = m_shard_session_id.load(std::memory_order_relaxed);
+    if (shard_session_id != 0) {
+        WriteToShard(shard_session_id, spans, span_count, length);
+        if (!m_is_stdout && !m_shared_ring.IsOpened() && !m_console_sink.IsOpened() && !m_is_socket_opened) return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(m_output_mutex);
+
+    if (m_file) {
+        if (m_index_file) IndexEntry(length, severity);
+
+        // Text which doesn't fit in batch is written directly from spans, after batched entries, so it isn't copied.
+        if (m_file_batch_size > 0 && (m_is_compressed || length < m_file_batch_size)) {
+            for (size_t index = 0; index < span_count; ++index) m_file_batch.append(spans[index].data, spans[index].length);
+
+            if (m_is_collect_stats && m_file_batch.length() > m_stats_max_batch_length.load(std::memory_order_relaxed)) {
+                m_stats_max_batch_length.store(m_file_batch.length(), std::memory_order_relaxed);
+            }
+
+            if (m_file_batch.length() >= m_file_batch_size) WriteFileBatch();
+        } else {
+            WriteFileBatch();
+            WriteToFile(spans, span_count);
+        }
+    }
+
+    // Ring buffer, socket, asynchronous and utf-16 console copy text anyway, so spans are joined for them only if there are more than one.
+    std::string joined;
+    const char* text = span_count > 0 ? spans[0].data : "";
+    if (span_count > 1 && (m_shared_ring.IsOpened() || m_is_socket_opened || m_console_sink.IsOpened() || (m_is_stdout && fwide(stdout, 0) > 0))) {
+        joined.reserve(length);
+        for (size_t index = 0; index < span_count; ++index) joined.append(spans[index].data, spans[index].length);
+        text = joined.c_str();
+    }
+
+    if (m_shared_ring.IsOpened()) {
+        if (!m_shared_ring.Push(text, length) && m_is_collect_stats) {
+            m_stats_dropped_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#ifdef LOGGER_USE_SOCKET
+    if (m_is_socket_opened) {
+        if (!m_socket_sink->Push(text, length, severity) && m_is_collect_stats) {
+            m_stats_dropped_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#endif
+    if (m_console_sink.IsOpened()) {
+        if (!m_console_sink.Push(text, length, severity) && m_is_collect_stats) {
+            m_stats_dropped_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (m_is_stdout) {
+        const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        {
+            UTF8_Guardian utf8_guardian;
+
+            if (fwide(stdout, 0) > 0) {
+                wprintf(L"%ls", ToUTF16(std::string(text, length)).c_str());
+            } else {
+                for (size_t index = 0; index < span_count; ++index) fwrite(spans[index].data, sizeof(char), spans[index].length, stdout);
+            }
+            fflush(stdout);
+        }
+
+        if (m_is_collect_stats) {
+            m_stats_write_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+        }
+    }
+}
+
+LOGGER_INLINE void Logger::WriteToFile(const char* text, size_t length) {
+    const LoggerSpan span = {text, length};
+    WriteToFile(&span, 1);
+}
+
+LOGGER_INLINE void Logger::WriteToFile(const LoggerSpan* spans, size_t span_count) {
+    if (!TryWriteToFile(spans, span_count)) {
+        TOSTR_INNER_FATAL_ERROR("Logger::LogText: Failed write the text to the log file.");
+    }
+}
+
+LOGGER_INLINE bool Logger::TryWriteToFile(const LoggerSpan* spans, size_t span_count) {
+    const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    for (size_t index = 0; index < span_count; ++index) {
+        const size_t count = fwrite(spans[index].data, sizeof(char), spans[index].length, m_file);
+        if (count != spans[index].length) return false;
+    }
+
+    fflush(m_file);
+
+    if (m_is_collect_stats) {
+        m_stats_flush_count.fetch_add(1, std::memory_order_relaxed);
+        m_stats_write_time_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+LOGGER_INLINE void Logger::IndexEntry(size_t length, int severity) {
+    int64_t& entry_time_ns = GetThreadEntryTimeRef();
+    int64_t now_ns = entry_time_ns;
+    entry_time_ns = 0;
+
+    if (now_ns == 0 && (m_index_span.entry_count == 0 || (m_index_span.entry_count + 1) % INDEX_TIME_CHECK_INTERVAL == 0)) {
+        now_ns = GetSystemTimeNS();
+    }
+
+    // Clock could be set back, but binary search of reader needs spans which don't go back in time.
+    if (now_ns > m_index_time_ns) m_index_time_ns = now_ns;
+
+    if (m_index_span.entry_count == 0) {
+        m_index_span.offset         = m_index_file_size;
+        m_index_span.begin_time_ns  = m_index_time_ns;
+        m_index_span_deadline_ns    = m_index_time_ns + m_index_time_interval_ns;
+    }
+    m_index_span.end_time_ns = m_index_time_ns;
+    LoggerFileIndex::CountEntry(m_index_span, severity);
+    m_index_file_size += length;
+
+    if (m_index_span.entry_count >= m_index_entry_interval || m_index_time_ns >= m_index_span_deadline_ns) {
+        WriteIndexRecord();
+    }
+}
+
+LOGGER_INLINE void Logger::WriteIndexRecord() {
+    unsigned char record[LoggerFileIndex::RECORD_SIZE];
+    LoggerFileIndex::EncodeRecord(record, m_index_span);
+    if (fwrite(record, 1, sizeof(record), m_index_file) != sizeof(record)) {
+        TOSTR_INNER_FATAL_ERROR("Logger::LogText: Failed write the record to the index file.");
+    }
+
+    m_index_span = {};
+}
+
+LOGGER_INLINE int64_t Logger::GetSystemTimeNS() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+LOGGER_INLINE void Logger::LogEntry(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    LogEntryV(stats_index, severity, category_prefix, category_prefix_length, format, arguments);
+    va_end(arguments);
+}
+
+LOGGER_INLINE void Logger::LogEntryV(StatsIndex stats_index, int severity, const char* category_prefix, size_t category_prefix_length, const char* format, va_list arguments) {
+    const bool is_collect_stats = m_is_collect_stats;
+    const auto begin = is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    std::string entry = GenerateEntryPrefix(category_prefix, category_prefix_length);
+    AppendFormattedV(entry, format, arguments);
+    OutputEntry(stats_index, severity, entry, begin);
+}
+
+LOGGER_INLINE void Logger::LogTraceEntry(const char* function_name, const char* format, ...) {
+    const std::string category_prefix = GenerateTraceCategoryPrefix(function_name);
+
+    va_list arguments;
+    va_start(arguments, format);
+    LogEntryV(STATS_TRACE, LoggerCategory::Trace::SEVERITY, category_prefix.c_str(), category_prefix.length(), format, arguments);
+    va_end(arguments);
+}
+
+LOGGER_INLINE void Logger::LogHexDumpEntry(const void* data, size_t size, const char* format, ...) {
+    const auto begin = m_is_collect_stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    va_list arguments;
+    va_start(arguments, format);
+    std::string entry = GenerateEntryPrefix<LoggerCategory::Dump>();
+    AppendFormattedV(entry, format, arguments);
+    va_end(arguments);
+
+    OutputHexDumpEntry(entry, data, size, begin);
+}
+
+LOGGER_INLINE void Logger::OutputEntry(StatsIndex stats_index, int severity, std::string& entry, std::chrono::steady_clock::time_point begin) {
+    const bool is_collect_stats = m_is_collect_stats;
+
+    entry += "\n";
+
+    if (is_collect_stats) CountEntry(stats_index, entry.length(), begin);
+
+    OutputText(entry, severity);
+
+    if (is_collect_stats) LogStatsIfDue(std::chrono::steady_clock::now());
+}
+
+LOGGER_INLINE void Logger::OutputHexDumpEntry(std::string& entry, const void* data, size_t size, std::chrono::steady_clock::time_point begin) {
+    const bool is_collect_stats = m_is_collect_stats;
+
+    entry += "\n";
+
+    const size_t dumped_size = (size < m_hex_dump_limit) ? size : m_hex_dump_limit;
+    AppendHexDump(entry, static_cast<const unsigned char*>(data), dumped_size);
+    if (dumped_size < size) {
+        AppendFormatted(entry, "(%llu more bytes not dumped)\n", (unsigned long long)(size - dumped_size));
+    }
+
+    if (is_collect_stats) CountEntry(STATS_DUMP, entry.length(), begin);
+
+    OutputText(entry, LoggerCategory::Dump::SEVERITY);
+
+    if (is_collect_stats) LogStatsIfDue(std::chrono::steady_clock::now());
+}
+
+LOGGER_INLINE void Logger::LogFatalErrorEntry(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    const std::string message = GenerateMessageV(format, arguments);
+    va_end(arguments);
+
+    LogFatalErrorMessage(message);
+}
+
+LOGGER_INLINE void Logger::LogFatalErrorMessage(const std::string& message) {
+    Log<LoggerCategory::FatalError>("%s", message.c_str());
+    Flush();
+    CloseAsyncOutputs();
+
+    if (m_do_at_fatal_error) m_do_at_fatal_error(message.c_str()); 
+    exit(EXIT_FAILURE);
+}
+
+LOGGER_INLINE void Logger::AppendHexDump(std::string& text, const unsigned char* data, size_t size) {
+    const size_t BYTES_PER_LINE = 16;
+    const size_t HEX_BEGIN      = 10;                                   // after offset and two spaces
+    const size_t ASCII_BEGIN    = HEX_BEGIN + BYTES_PER_LINE * 3 + 3;   // after hex bytes, extra space in the middle and " |"
+    const size_t LINE_LENGTH    = ASCII_BEGIN + BYTES_PER_LINE + 2;     // with "|\n"
+
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    const size_t line_count = (size + BYTES_PER_LINE - 1) / BYTES_PER_LINE;
+    if (line_count == 0) return;
+
+    // Lines are written directly to text, each line has full length and last one is shortened at the end.
+    const size_t begin = text.length();
+    text.resize(begin + line_count * LINE_LENGTH, ' ');
+    char* line = &text[begin];
+
+    for (size_t offset = 0; offset < size; offset += BYTES_PER_LINE, line += LINE_LENGTH) {
+        for (size_t index = 0; index < 8; ++index) {
+            line[index] = HEX_DIGITS[(offset >> (28 - index * 4)) & 0xF];
+        }
+
+        const size_t count = (size - offset < BYTES_PER_LINE) ? (size - offset) : BYTES_PER_LINE;
+        char* hex = line + HEX_BEGIN;
+        char* ascii = line + ASCII_BEGIN;
+
+        for (size_t index = 0; index < count; ++index) {
+            const unsigned char byte = data[offset + index];
+
+            hex[0] = HEX_DIGITS[byte >> 4];
+            hex[1] = HEX_DIGITS[byte & 0xF];
+            hex += (index == 7) ? 4 : 3;
+
+            ascii[index] = (byte >= 0x20 && byte < 0x7F) ? char(byte) : '.';
+        }
+
+        ascii[-1]           = '|';
+        ascii[count]        = '|';
+        ascii[count + 1]    = '\n';
+    }
+
+    // Removes padding after last line.
+    const size_t last_count = size - (line_count - 1) * BYTES_PER_LINE;
+    text.resize(begin + (line_count - 1) * LINE_LENGTH + ASCII_BEGIN + last_count + 2);
+}
+
+LOGGER_INLINE std::string Logger::GenerateTraceCategoryPrefix(const char* function_name) {
+    std::string category_prefix = "[Trace][";
+    category_prefix += function_name;
+    category_prefix += "]: ";
+    return category_prefix;
+}
+
+LOGGER_INLINE std::string Logger::GenerateEntryPrefix(const char* category_prefix, size_t category_prefix_length) {
+    std::string prefix;
+
+    if (m_is_log_time) {
+        prefix += GenerateTime();
+    } else {
+        GetThreadEntryTimeRef() = 0;
+    }
+    if (!m_name.empty()) {
+        prefix += '[';
+        prefix += m_name;
+        prefix += ']';
+    }
+
+    const std::string& context = GetThreadContextRef();
+    if (context.empty()) {
+        prefix.append(category_prefix, category_prefix_length);
+    } else {
+        prefix.append(category_prefix, category_prefix_length - 2); // without ": "
+        prefix += context;
+        prefix += ": ";
+    }
+
+    return prefix;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE std::string Logger::GenerateTime() {
+    const auto now_point = std::chrono::system_clock::now();
+    GetThreadEntryTimeRef() = std::chrono::duration_cast<std::chrono::nanoseconds>(now_point.time_since_epoch()).count();
+
+    const time_t now = std::chrono::system_clock::to_time_t(now_point);
+    tm ti = {};
+    localtime_s(&ti, &now);
+
+    return GenerateMessage("[%d/%02d/%02d %02d:%02d:%02d]", 1900 + ti.tm_year, 1 + ti.tm_mon, ti.tm_mday, ti.tm_hour, ti.tm_min, ti.tm_sec);
+}
+
+LOGGER_INLINE void Logger::InnerFatalError(const char* message, const wchar_t* message_utf16) {
+    CloseAsyncOutputs();
+
+    {
+        UTF8_Guardian utf8_guardian;
+
+        if (fwide(stdout, 0) > 0) {
+            wprintf(L"%ls\n", message_utf16);
+        } else {
+            printf("%s\n", message);
+        }
+        fflush(stdout);
+    }
+
+    if (m_do_at_fatal_error) m_do_at_fatal_error(message);
+    exit(EXIT_FAILURE);
+}
+
+LOGGER_INLINE void Logger::CloseAsyncOutputs() {
+    CloseAsyncStdOut();
+#ifdef LOGGER_USE_SOCKET
+    CloseSocket();
+#endif
+}
+
+LOGGER_INLINE std::string Logger::GenerateMessage(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    std::string message = GenerateMessageV(format, arguments);
+    va_end(arguments);
+
+    return message;
+}
+
+LOGGER_INLINE std::string Logger::GenerateMessageV(const char* format, va_list arguments) {
+    std::string message;
+    AppendFormattedV(message, format, arguments);
+    return message;
+}
+
+LOGGER_INLINE void Logger::AppendFormatted(std::string& text, const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    AppendFormattedV(text, format, arguments);
+    va_end(arguments);
+}
+
+LOGGER_INLINE void Logger::AppendFormattedV(std::string& text, const char* format, va_list arguments) {
+    enum { SIZE = 4096 };
+    char stack_buffer[SIZE];
+
+    // Arguments are read twice, if message doesn't fit in stack buffer.
+    va_list arguments_copy;
+    va_copy(arguments_copy, arguments);
+    const int count = vsnprintf(stack_buffer, SIZE, format, arguments_copy);
+    va_end(arguments_copy);
+
+    if (count < 0) {
+        TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Wrong encoding.");
+    }
+
+    if (count >= SIZE) {
+        // Formats directly into text, without intermediate buffer. Terminating null is written to text's own null.
+        const size_t length = text.length();
+        text.resize(length + count);
+
+        const int second_count = vsnprintf(&text[length], count + 1, format, arguments);
+
+        if (second_count < 0) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Wrong encoding (at second try).");
+        }
+        if (second_count > count) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::GenerateMessage: Can not write to buffer.");
+        }
+
+        text.resize(length + second_count);
+    } else {
+        text.append(stack_buffer, count);
+    }
+}
+
+LOGGER_INLINE char Logger::AppendFormatUntilSpecifier(std::string& text, const char*& format, char* specifier, size_t specifier_size) {
+    // Conversion characters, including 'C' and 'S' of msvc.
+    static const char CONVERSIONS[] = "diouxXeEfFgGaAcCsSpn";
+
+    for (;;) {
+        const char* percent = strchr(format, '%');
+        if (!percent) {
+            text += format;
+            format += strlen(format);
+            return 0;
+        }
+
+        text.append(format, percent - format);
+        format = percent;
+
+        if (format[1] == '%') {
+            text += '%';
+            format += 2;
+            continue;
+        }
+
+        // Flags, width, precision and length modifier are copied together with conversion character.
+        size_t length = 1;
+        while (format[length] != '\0' && !strchr(CONVERSIONS, format[length])) {
+            if (format[length] == '*') {
+                TOSTR_INNER_FATAL_ERROR("Error Logger::AppendFormatUntilSpecifier: Width or precision given by argument ('*') is not supported, when arguments are formatted by LoggerFormatter.");
+            }
+            ++length;
+        }
+        if (format[length] == '\0') {
+            // Incomplete specifier at the end of format is logged as it is.
+            text += format;
+            format += length;
+            return 0;
+        }
+        ++length;
+
+        if (length >= specifier_size) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::AppendFormatUntilSpecifier: Too long format specifier.");
+        }
+        memcpy(specifier, format, length);
+        specifier[length] = '\0';
+
+        format += length;
+        return specifier[length - 1];
+    }
+}
+
+LOGGER_INLINE std::wstring Logger::ToUTF16(const std::string& text_utf8) {
+    std::wstring text_utf16;
+
+    enum { DEFAULT_SIZE = 4096 };
+    wchar_t stack_buffer[DEFAULT_SIZE] = {};
+
+    if (!text_utf8.empty()) {
+        int size = MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, NULL, 0);
+        if (size == 0) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::ToUTF16: Can not convert a text from utf-16 to utf-8.");
+        }
+
+        wchar_t* buffer = (size > DEFAULT_SIZE) ? (new wchar_t[size]) : stack_buffer;
+
+        size = MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, buffer, size);
+        if (size == 0) {
+            TOSTR_INNER_FATAL_ERROR("Error Logger::ToUTF16: Can not convert a text from utf-16 to utf-8.");
+        }
+
+        if (size > 1) text_utf16 = std::wstring(buffer, size - 1);
+
+        if (buffer != stack_buffer) delete[] buffer;
+    }
+
+    return text_utf16;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE size_t Logger::DecodeUTF8Sequence(const unsigned char* text, size_t size, size_t& invalid_length) {
+    const unsigned char lead = text[0];
+
+    size_t          length;
+    unsigned char   min = 0x80;
+    unsigned char   max = 0xBF;
+
+    if (lead < 0x80) {
+        return 1;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) min = 0xA0;       // overlong
+        else if (lead == 0xED) max = 0x9F;  // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) min = 0x90;       // overlong
+        else if (lead == 0xF4) max = 0x8F;  // above U+10FFFF
+    } else {
+        invalid_length = 1;
+        return 0;
+    }
+
+    for (size_t index = 1; index < length; ++index) {
+        if (index >= size || text[index] < min || text[index] > max) {
+            invalid_length = index;
+            return 0;
+        }
+        min = 0x80;
+        max = 0xBF;
+    }
+    return length;
+}
+
+LOGGER_INLINE size_t Logger::FindInvalidUTF8(const char* text, size_t size) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text);
+    size_t index = 0;
+
+    while (index < size) {
+        // Fast path: skips blocks of pure ascii.
+    #if LOGGER_SSE2
+        while (index + 16 <= size && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index))) == 0) {
+            index += 16;
+        }
+    #else
+        while (index + 8 <= size) {
+            unsigned long long block;
+            memcpy(&block, data + index, sizeof(block));
+            if (block & 0x8080808080808080ULL) break;
+            index += 8;
+        }
+    #endif
+        if (index >= size) break;
+
+        if (data[index] < 0x80) {
+            ++index;
+        } else {
+            size_t invalid_length;
+            const size_t length = DecodeUTF8Sequence(data + index, size - index, invalid_length);
+            if (length == 0) return index;
+            index += length;
+        }
+    }
+    return size;
+}
+
+LOGGER_INLINE bool Logger::IsValidUTF8(const std::string& text) {
+    return FindInvalidUTF8(text.c_str(), text.length()) == text.length();
+}
+
+LOGGER_INLINE void Logger::SanitizeUTF8(std::string& text) {
+    size_t position = FindInvalidUTF8(text.c_str(), text.length());
+    if (position == text.length()) return;
+
+    static const char REPLACEMENT[] = "\xEF\xBF\xBD"; // U+FFFD
+
+    std::string sanitized;
+    sanitized.reserve(text.length() + 16);
+    sanitized.append(text, 0, position);
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.c_str());
+    const size_t size = text.length();
+
+    while (position < size) {
+        size_t invalid_length;
+        const size_t length = DecodeUTF8Sequence(data + position, size - position, invalid_length);
+        if (length == 0) {
+            sanitized.append(REPLACEMENT, sizeof(REPLACEMENT) - 1);
+            position += invalid_length;
+        } else {
+            const size_t next = position + length + FindInvalidUTF8(text.c_str() + position + length, size - position - length);
+            sanitized.append(text, position, next - position);
+            position = next;
+        }
+    }
+
+    text.swap(sanitized);
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE Logger::Context::Context(const std::string& key, const std::string& value) {
+    std::string& context = GetThreadContextRef();
+    m_previous_length = context.length();
+
+    context += '[';
+    context += key;
+    context += '=';
+    context += value;
+    context += ']';
+}
+
+LOGGER_INLINE Logger::Context::~Context() {
+    GetThreadContextRef().resize(m_previous_length);
+}
+
+LOGGER_INLINE const std::string& Logger::GetContext() {
+    return GetThreadContextRef();
+}
+
+LOGGER_INLINE std::string& Logger::GetThreadContextRef() {
+    thread_local std::string s_thread_context;
+    return s_thread_context;
+}
+
+LOGGER_INLINE int64_t& Logger::GetThreadEntryTimeRef() {
+    thread_local int64_t s_thread_entry_time_ns = 0;
+    return s_thread_entry_time_ns;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE Logger::TrackedScope*& Logger::GetThreadTrackedScopeRef() {
+    thread_local TrackedScope* s_thread_tracked_scope = nullptr;
+    return s_thread_tracked_scope;
+}
+
+LOGGER_INLINE void Logger::LogSlowScope(const TrackedScope& scope, std::chrono::steady_clock::duration duration, std::chrono::steady_clock::duration threshold) {
+    if (!IsEnabled<SlowScope>()) {
+        CountSuppressed();
+        return;
+    }
+
+    // Path is collected from innermost scope, so it's reversed.
+    std::vector<const char*> function_names;
+    for (const TrackedScope* current = &scope; current; current = current->parent) function_names.push_back(current->function_name);
+
+    std::string path;
+    for (auto it = function_names.rbegin(); it != function_names.rend(); ++it) {
+        if (!path.empty()) path += " > ";
+        path += *it;
+    }
+
+    Log<SlowScope>("%s took %.3f ms (threshold %.3f ms), path: %s.", scope.function_name, 
+        std::chrono::duration<double, std::milli>(duration).count(), 
+        std::chrono::duration<double, std::milli>(threshold).count(), 
+        path.c_str());
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE const char* LoggerCallSite::GetFile() const {
+    return m_file;
+}
+
+LOGGER_INLINE int LoggerCallSite::GetLine() const {
+    return m_line;
+}
+
+LOGGER_INLINE const char* LoggerCallSite::GetFunctionName() const {
+    return m_function_name;
+}
+
+LOGGER_INLINE const char* LoggerCallSite::GetCategoryName() const {
+    return m_category_name;
+}
+
+LOGGER_INLINE bool LoggerCallSite::Register() const {
+    Logger::CallSites& call_sites = Logger::GetCallSitesRef();
+    std::lock_guard<std::mutex> lock(call_sites.mutex);
+
+    // Other thread could register call site in the meantime.
+    const uint8_t state = m_state.load(std::memory_order_relaxed);
+    if (state != STATE_UNREGISTERED) return state == STATE_ENABLED;
+
+    bool is_enabled = true;
+    for (const Logger::CallSiteRule& rule : call_sites.rules) {
+        if (IsMatching(rule.pattern.c_str())) is_enabled = rule.is_enabled;
+    }
+
+    m_next = call_sites.first;
+    call_sites.first = this;
+    m_state.store(is_enabled ? STATE_ENABLED : STATE_DISABLED, std::memory_order_relaxed);
+
+    return is_enabled;
+}
+
+LOGGER_INLINE bool LoggerCallSite::IsMatching(const char* pattern) const {
+    if (Logger::IsMatchingPattern(m_function_name, pattern))    return true;
+    if (Logger::IsMatchingPattern(m_category_name, pattern))    return true;
+    if (Logger::IsMatchingPattern(m_file, pattern))             return true;
+
+    const std::string location = std::string(m_file) + ":" + std::to_string(m_line);
+    return Logger::IsMatchingPattern(location.c_str(), pattern);
+}
+
+LOGGER_INLINE void Logger::EnableCallSites(const std::string& pattern) {
+    SetCallSites(pattern, true);
+}
+
+LOGGER_INLINE void Logger::DisableCallSites(const std::string& pattern) {
+    SetCallSites(pattern, false);
+}
+
+LOGGER_INLINE std::vector<const LoggerCallSite*> Logger::GetCallSites() {
+    CallSites& call_sites = GetCallSitesRef();
+    std::lock_guard<std::mutex> lock(call_sites.mutex);
+
+    std::vector<const LoggerCallSite*> list;
+    for (const LoggerCallSite* call_site = call_sites.first; call_site; call_site = call_site->m_next) {
+        list.push_back(call_site);
+    }
+    return list;
+}
+
+LOGGER_INLINE Logger::CallSites& Logger::GetCallSitesRef() {
+    static CallSites s_call_sites = { {}, nullptr, {} };
+    return s_call_sites;
+}
+
+LOGGER_INLINE void Logger::SetCallSites(const std::string& pattern, bool is_enabled) {
+    CallSites& call_sites = GetCallSitesRef();
+    std::lock_guard<std::mutex> lock(call_sites.mutex);
+
+    // Rule for all call sites overrides earlier rules, so they don't need to be kept.
+    if (pattern == "*") call_sites.rules.clear();
+    call_sites.rules.push_back({ pattern, is_enabled });
+
+    for (const LoggerCallSite* call_site = call_sites.first; call_site; call_site = call_site->m_next) {
+        if (call_site->IsMatching(pattern.c_str())) {
+            call_site->m_state.store(is_enabled ? LoggerCallSite::STATE_ENABLED : LoggerCallSite::STATE_DISABLED, std::memory_order_relaxed);
+        }
+    }
+}
+
+LOGGER_INLINE bool Logger::IsMatchingPattern(const char* text, const char* pattern) {
+    // On mismatch, last '*' is extended by one character.
+    const char* star_pattern    = nullptr;
+    const char* star_text       = nullptr;
+
+    while (*text) {
+        if (*pattern == '*') {
+            star_pattern    = pattern++;
+            star_text       = text;
+        } else if (*pattern == '?' || *pattern == *text) {
+            ++pattern;
+            ++text;
+        } else if (star_pattern) {
+            pattern = star_pattern + 1;
+            text    = ++star_text;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') ++pattern;
+
+    return *pattern == '\0';
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerRegistry::LoggerRegistry() {
+    m_snapshot = nullptr;
+}
+
+LOGGER_INLINE LoggerRegistry::~LoggerRegistry() {
+    m_root.Flush();
+}
+
+LOGGER_INLINE Logger& LoggerRegistry::GetRoot() {
+    return m_root;
+}
+
+LOGGER_INLINE Logger& LoggerRegistry::Get(const std::string& name) {
+    if (name.empty()) return m_root;
+
+    const Snapshot* snapshot = m_snapshot.load(std::memory_order_acquire);
+    if (snapshot) {
+        auto it = snapshot->find(name);
+        if (it != snapshot->end()) return *it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Another thread could create logger in the meantime.
+    auto it = m_loggers.find(name);
+    if (it != m_loggers.end()) return *it->second;
+
+    const Logger* ancestor = &m_root;
+    for (size_t position = name.rfind('.'); position != std::string::npos && position > 0; position = name.rfind('.', position - 1)) {
+        auto ancestor_it = m_loggers.find(name.substr(0, position));
+        if (ancestor_it != m_loggers.end()) {
+            ancestor = ancestor_it->second.get();
+            break;
+        }
+    }
+
+    Logger* logger = new Logger();
+    m_loggers[name] = std::unique_ptr<Logger>(logger);
+
+    logger->m_name                  = name;
+    logger->m_output                = &m_root;
+    logger->m_do_at_fatal_error     = ancestor->m_do_at_fatal_error;
+    logger->m_is_log_time           = ancestor->m_is_log_time;
+    logger->m_is_log_trace          = ancestor->m_is_log_trace;
+    logger->m_is_log_dump           = ancestor->m_is_log_dump;
+    logger->m_is_log_event          = ancestor->m_is_log_event;
+    logger->m_is_log_warning        = ancestor->m_is_log_warning;
+    logger->m_is_sanitize_utf8      = ancestor->m_is_sanitize_utf8;
+    logger->m_is_collect_stats      = ancestor->m_is_collect_stats;
+    logger->m_hex_dump_limit        = ancestor->m_hex_dump_limit;
+    logger->m_min_severity          = ancestor->m_min_severity;
+    logger->m_disabled_categories   = ancestor->m_disabled_categories;
+
+    // Logger is published after it is set up.
+    Snapshot* new_snapshot = m_snapshots.empty() ? new Snapshot() : new Snapshot(*m_snapshots.back());
+    (*new_snapshot)[name] = logger;
+    m_snapshots.push_back(std::unique_ptr<const Snapshot>(new_snapshot));
+    m_snapshot.store(new_snapshot, std::memory_order_release);
+
+    return *logger;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE void LoggerBlockCodec::WriteUInt32(unsigned char* data, uint32_t value) {
+    data[0] = (unsigned char)(value);
+    data[1] = (unsigned char)(value >> 8);
+    data[2] = (unsigned char)(value >> 16);
+    data[3] = (unsigned char)(value >> 24);
+}
+
+LOGGER_INLINE uint32_t LoggerBlockCodec::ReadUInt32(const unsigned char* data) {
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+LOGGER_INLINE void LoggerBlockCodec::AppendFrame(std::string& frame, LoggerCompression compression, const char* text, size_t size) {
+    const size_t begin = frame.length();
+    frame.resize(begin + HEADER_SIZE);
+
+    Codec codec = CODEC_STORED;
+    std::string payload;
+
+    if (compression == LoggerCompression::LZ) {
+        CompressLZ(text, size, payload);
+        codec = CODEC_LZ;
+    }
+#ifdef LOGGER_USE_ZLIB
+    if (compression == LoggerCompression::ZLIB) {
+        uLongf payload_size = compressBound(uLong(size));
+        payload.resize(payload_size);
+        if (compress2(reinterpret_cast<Bytef*>(&payload[0]), &payload_size, reinterpret_cast<const Bytef*>(text), uLong(size), Z_DEFAULT_COMPRESSION) == Z_OK) {
+            payload.resize(payload_size);
+            codec = CODEC_ZLIB;
+        }
+    }
+#endif
+
+    if (codec == CODEC_STORED || payload.length() >= size) {
+        codec = CODEC_STORED;
+        frame.append(text, size);
+    } else {
+        frame.append(payload);
+    }
+
+    unsigned char* header = reinterpret_cast<unsigned char*>(&frame[begin]);
+    memcpy(header, "LGBK", 4);
+    header[4] = (unsigned char)codec;
+    header[5] = header[6] = header[7] = 0;
+    WriteUInt32(header + 8, uint32_t(size));
+    WriteUInt32(header + 12, uint32_t(frame.length() - begin - HEADER_SIZE));
+}
+
+LOGGER_INLINE bool LoggerBlockCodec::DecodeHeader(const unsigned char* data, Header& header) {
+    if (memcmp(data, "LGBK", 4) != 0 || data[4] > CODEC_ZLIB) return false;
+
+    header.codec        = Codec(data[4]);
+    header.text_size    = ReadUInt32(data + 8);
+    header.payload_size = ReadUInt32(data + 12);
+
+    return header.text_size <= MAX_BLOCK_SIZE && header.payload_size <= MAX_BLOCK_SIZE;
+}
+
+LOGGER_INLINE bool LoggerBlockCodec::DecodePayload(const Header& header, const char* payload, std::string& text) {
+    switch (header.codec) {
+    case CODEC_STORED:
+        if (header.payload_size != header.text_size) return false;
+        text.assign(payload, header.payload_size);
+        return true;
+
+    case CODEC_LZ:
+        return DecompressLZ(payload, header.payload_size, header.text_size, text);
+
+    case CODEC_ZLIB: {
+    #ifdef LOGGER_USE_ZLIB
+        uLongf text_size = header.text_size;
+        text.resize(text_size);
+        if (text_size == 0) return true;
+        return uncompress(reinterpret_cast<Bytef*>(&text[0]), &text_size, reinterpret_cast<const Bytef*>(payload), header.payload_size) == Z_OK 
+            && text_size == header.text_size;
+    #else
+        return false;
+    #endif
+    }
+    }
+    return false;
+}
+
+LOGGER_INLINE void LoggerBlockCodec::CompressLZ(const char* text, size_t size, std::string& compressed) {
+    enum {
+        MIN_MATCH       = 4,
+        LAST_LITERALS   = 5,    // last bytes of block are always literals
+        MATCH_LIMIT     = 12,   // match can not start in last bytes of block
+        MAX_OFFSET      = 65535,
+        HASH_BITS       = 12
+    };
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text);
+
+    compressed.clear();
+    compressed.reserve(size + size / 255 + 16);
+
+    auto AppendLength = [&compressed](size_t length) {
+        for (; length >= 255; length -= 255) compressed += char(255);
+        compressed += char(length);
+    };
+
+    auto AppendSequence = [&](size_t literal_begin, size_t literal_length, size_t offset, size_t match_length) {
+        const size_t token_position = compressed.length();
+        compressed += char(0);
+
+        unsigned char token = (unsigned char)((literal_length < 15 ? literal_length : 15) << 4);
+        if (literal_length >= 15) AppendLength(literal_length - 15);
+        compressed.append(text + literal_begin, literal_length);
+
+        if (match_length > 0) {
+            compressed += char(offset & 0xFF);
+            compressed += char(offset >> 8);
+
+            const size_t length = match_length - MIN_MATCH;
+            token |= (unsigned char)(length < 15 ? length : 15);
+            if (length >= 15) AppendLength(length - 15);
+        }
+        compressed[token_position] = char(token);
+    };
+
+    auto Read32 = [data](size_t position) {
+        uint32_t value;
+        memcpy(&value, data + position, sizeof(value));
+        return value;
+    };
+
+    size_t anchor = 0;
+
+    if (size > MATCH_LIMIT) {
+        std::vector<int32_t> table(size_t(1) << HASH_BITS, -1);
+
+        size_t position = 0;
+        while (position < size - MATCH_LIMIT) {
+            const uint32_t sequence = Read32(position);
+            const uint32_t hash     = (sequence * 2654435761U) >> (32 - HASH_BITS);
+            const int32_t reference = table[hash];
+
+            table[hash] = int32_t(position);
+
+            if (reference >= 0 && position - reference <= MAX_OFFSET && Read32(reference) == sequence) {
+                size_t match_length = MIN_MATCH;
+                while (position + match_length < size - LAST_LITERALS && data[reference + match_length] == data[position + match_length]) {
+                    ++match_length;
+                }
+
+                AppendSequence(anchor, position - anchor, position - reference, match_length);
+
+                position += match_length;
+                anchor = position;
+            } else {
+                ++position;
+            }
+        }
+    }
+
+    AppendSequence(anchor, size - anchor, 0, 0);
+}
+
+LOGGER_INLINE bool LoggerBlockCodec::DecompressLZ(const char* compressed, size_t size, size_t text_size, std::string& text) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(compressed);
+    const unsigned char* end = data + size;
+
+    text.clear();
+    text.reserve(text_size);
+
+    auto ReadLength = [&data, end](size_t& length) {
+        unsigned char byte;
+        do {
+            if (data >= end) return false;
+            byte = *data++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (data < end) {
+        const unsigned char token = *data++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLength(literal_length)) return false;
+        if (size_t(end - data) < literal_length || text.length() + literal_length > text_size) return false;
+
+        text.append(reinterpret_cast<const char*>(data), literal_length);
+        data += literal_length;
+
+        if (data == end) break; // last sequence has only literals
+
+        if (end - data < 2) return false;
+        const size_t offset = size_t(data[0]) | (size_t(data[1]) << 8);
+        data += 2;
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !ReadLength(match_length)) return false;
+        match_length += 4;
+
+        if (offset == 0 || offset > text.length() || text.length() + match_length > text_size) return false;
+
+        // Byte by byte, since match can overlap with itself.
+        size_t source = text.length() - offset;
+        for (size_t index = 0; index < match_length; ++index) text += text[source + index];
+    }
+
+    return text.length() == text_size;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerSharedRing::LoggerSharedRing() {
+    m_mapping           = NULL;
+    m_header            = nullptr;
+    m_slots             = nullptr;
+    m_stalled_position  = 0;
+}
+
+LOGGER_INLINE LoggerSharedRing::~LoggerSharedRing() {
+    Close();
+}
+
+LOGGER_INLINE bool LoggerSharedRing::ToUTF16(const std::string& text_utf8, std::wstring& text_utf16) {
+    const int size = MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, NULL, 0);
+    if (size <= 0) return false;
+
+    text_utf16.assign(size, L'\0');
+    if (MultiByteToWideChar(CP_UTF8, 0, text_utf8.c_str(), -1, &text_utf16[0], size) == 0) return false;
+
+    text_utf16.resize(size - 1);
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Create(const std::string& name, size_t slot_count, size_t slot_size) {
+    Close();
+
+    slot_size = (slot_size + 7) / 8 * 8;
+    if (slot_count == 0 || slot_size <= SLOT_HEADER_SIZE || slot_size > 0xFFFFFFFF) return false;
+
+    std::wstring name_utf16;
+    if (!ToUTF16(name, name_utf16)) return false;
+
+    const unsigned long long size = HEADER_SIZE + (unsigned long long)slot_count * slot_size;
+
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, DWORD(size >> 32), DWORD(size & 0xFFFFFFFF), name_utf16.c_str());
+    if (mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return false;
+    }
+    if (!mapping || !Map(mapping)) return false;
+
+    // Memory of new mapping is zeroed, so no slot has valid sequence.
+    m_header->slot_size         = uint32_t(slot_size);
+    m_header->slot_count        = slot_count;
+    m_header->reserve_position  = 0;
+    m_header->read_position     = 0;
+    m_header->dropped_count     = 0;
+    m_header->abandoned_count   = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic             = MAGIC;
+
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Open(const std::string& name) {
+    Close();
+
+    std::wstring name_utf16;
+    if (!ToUTF16(name, name_utf16)) return false;
+
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name_utf16.c_str());
+    if (!mapping || !Map(mapping)) return false;
+
+    if (m_header->magic != MAGIC) {
+        Close();
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Map(HANDLE mapping) {
+    m_mapping = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!view) {
+        Close();
+        return false;
+    }
+
+    m_header    = static_cast<Header*>(view);
+    m_slots     = static_cast<char*>(view) + HEADER_SIZE;
+    return true;
+}
+
+LOGGER_INLINE void LoggerSharedRing::Close() {
+    if (m_header) {
+        UnmapViewOfFile(m_header);
+        m_header    = nullptr;
+        m_slots     = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+}
+
+LOGGER_INLINE bool LoggerSharedRing::IsOpened() const {
+    return m_header != nullptr;
+}
+
+LOGGER_INLINE LoggerSharedRing::SlotHeader* LoggerSharedRing::GetSlot(uint64_t position) const {
+    return reinterpret_cast<SlotHeader*>(m_slots + (position % m_header->slot_count) * m_header->slot_size);
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Push(const char* text, size_t length) {
+    uint64_t position;
+    return Reserve(length, position) && Commit(position, text, length);
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Reserve(size_t length, uint64_t& position) {
+    const size_t    payload_size    = m_header->slot_size - SLOT_HEADER_SIZE;
+    const uint64_t  count           = (length == 0) ? 1 : (length + payload_size - 1) / payload_size;
+
+    position = m_header->reserve_position.load(std::memory_order_relaxed);
+    do {
+        if (position + count - m_header->read_position.load(std::memory_order_acquire) > m_header->slot_count) {
+            m_header->dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_header->reserve_position.compare_exchange_weak(position, position + count, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Commit(uint64_t position, const char* text, size_t length) {
+    const size_t    payload_size    = m_header->slot_size - SLOT_HEADER_SIZE;
+    const uint64_t  count           = (length == 0) ? 1 : (length + payload_size - 1) / payload_size;
+
+    // First slot is committed last, so reader sees whole entry once first slot is committed.
+    // Slot is claimed only from sequence left by previous lap, so writer delayed until reader reclaimed its slot and 
+    // next lap reused it, doesn't overwrite entry of next lap. Commit is compare-and-swap from claim, so it fails 
+    // if reader has reclaimed slot in the meantime. Then entry is dropped and its remaining slots are released for reader.
+    for (uint64_t index = count; index-- > 0;) {
+        SlotHeader* slot = GetSlot(position + index);
+
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        bool is_committed = false;
+        if (IsFreeSequence(sequence, position + index) && slot->sequence.compare_exchange_strong(sequence, ToWritingSequence(position + index), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            const size_t begin = size_t(index) * payload_size;
+            const size_t chunk_length = (length - begin < payload_size) ? (length - begin) : payload_size;
+
+            memcpy(reinterpret_cast<char*>(slot) + SLOT_HEADER_SIZE, text + begin, chunk_length);
+            slot->slot_count    = (index == 0) ? uint32_t(count) : 0;
+            slot->length        = uint32_t(chunk_length);
+
+            sequence = ToWritingSequence(position + index);
+            is_committed = slot->sequence.compare_exchange_strong(sequence, position + index + 1, std::memory_order_release, std::memory_order_relaxed);
+        }
+
+        if (!is_committed) {
+            while (index-- > 0) {
+                SlotHeader* next = GetSlot(position + index);
+                uint64_t next_sequence = next->sequence.load(std::memory_order_acquire);
+                if (IsFreeSequence(next_sequence, position + index)) {
+                    next->sequence.compare_exchange_strong(next_sequence, ToReclaimedSequence(position + index), std::memory_order_release, std::memory_order_relaxed);
+                }
+            }
+            m_header->dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSharedRing::Pop(std::string& text, unsigned abandon_timeout_ms) {
+    uint64_t position = m_header->read_position.load(std::memory_order_relaxed);
+    if (position == m_header->reserve_position.load(std::memory_order_acquire)) return false;
+
+    SlotHeader* slot = GetSlot(position);
+
+    uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence != position + 1 || slot->slot_count == 0) {
+        // Slot released by writer, which failed to commit entry, is skipped immediately.
+        if (sequence != ToReclaimedSequence(position)) {
+            const auto now = std::chrono::steady_clock::now();
+
+            if (m_stalled_position != position + 1) {
+                m_stalled_position  = position + 1;
+                m_stall_begin       = now;
+                return false;
+            } 
+            if (now - m_stall_begin < std::chrono::milliseconds(abandon_timeout_ms)) return false;
+
+            // Slot is reclaimed by compare-and-swap, so writer which is still alive can't commit it later.
+            if (sequence != position + 1 && !slot->sequence.compare_exchange_strong(sequence, ToReclaimedSequence(position), std::memory_order_acq_rel)) {
+                return false;
+            }
+            m_header->abandoned_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Skips abandoned slot together with already committed or released next slots of the same entry.
+        ++position;
+        while (position != m_header->reserve_position.load(std::memory_order_acquire)) {
+            SlotHeader* next = GetSlot(position);
+            const uint64_t next_sequence = next->sequence.load(std::memory_order_acquire);
+            if (!(next_sequence == position + 1 && next->slot_count == 0) && next_sequence != ToReclaimedSequence(position)) break;
+            ++position;
+        }
+        m_header->read_position.store(position, std::memory_order_release);
+        m_stalled_position = 0;
+        return false;
+    }
+
+    const uint64_t count = slot->slot_count;
+
+    text.clear();
+    for (uint64_t index = 0; index < count; ++index) {
+        SlotHeader* next = GetSlot(position + index);
+        text.append(reinterpret_cast<const char*>(next) + SLOT_HEADER_SIZE, next->length);
+    }
+
+    m_header->read_position.store(position + count, std::memory_order_release);
+    m_stalled_position = 0;
+    return true;
+}
+
+LOGGER_INLINE uint64_t LoggerSharedRing::ToReclaimedSequence(uint64_t position) {
+    return (position + 1) | (uint64_t(1) << 63);
+}
+
+LOGGER_INLINE uint64_t LoggerSharedRing::ToWritingSequence(uint64_t position) {
+    return (position + 1) | (uint64_t(1) << 62);
+}
+
+LOGGER_INLINE bool LoggerSharedRing::IsFreeSequence(uint64_t sequence, uint64_t position) const {
+    const uint64_t slot_count = m_header->slot_count;
+    if (position < slot_count) return sequence == 0;
+    return sequence == position - slot_count + 1 || sequence == ToReclaimedSequence(position - slot_count);
+}
+
+LOGGER_INLINE uint64_t LoggerSharedRing::GetDroppedCount() const {
+    return m_header ? m_header->dropped_count.load(std::memory_order_relaxed) : 0;
+}
+
+LOGGER_INLINE uint64_t LoggerSharedRing::GetAbandonedCount() const {
+    return m_header ? m_header->abandoned_count.load(std::memory_order_relaxed) : 0;
+}
+
+//------------------------------------------------------------------------------
+
+#ifdef LOGGER_USE_SOCKET
+
+LOGGER_INLINE LoggerSocketSink::LoggerSocketSink() {
+    m_is_opened             = false;
+    m_is_wsa_started        = false;
+    m_type                  = LoggerSocketType::UDP;
+    m_framing               = LoggerSocketFraming::SYSLOG;
+    m_buffer_size           = 0;
+    m_address               = {};
+    m_address_length        = 0;
+    m_socket                = INVALID_SOCKET;
+    m_is_flush_requested    = false;
+    m_is_stop               = false;
+    m_sent_count            = 0;
+    m_dropped_count         = 0;
+}
+
+LOGGER_INLINE LoggerSocketSink::~LoggerSocketSink() {
+    Close();
+}
+
+LOGGER_INLINE bool LoggerSocketSink::Open(LoggerSocketType type, const std::string& address, LoggerSocketFraming framing, size_t buffer_size, const std::string& app_name) {
+    Close();
+
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) return false;
+    m_is_wsa_started = true;
+
+    m_type          = type;
+    m_framing       = framing;
+    m_buffer_size   = buffer_size;
+    m_address       = {};
+
+    if (type == LoggerSocketType::UNIX) {
+        sockaddr_un* address_unix = reinterpret_cast<sockaddr_un*>(&m_address);
+        if (address.empty() || address.length() >= sizeof(address_unix->sun_path)) {
+            Close();
+            return false;
+        }
+        address_unix->sun_family = AF_UNIX;
+        memcpy(address_unix->sun_path, address.c_str(), address.length() + 1);
+        m_address_length = int(sizeof(sockaddr_un));
+    } else {
+        const size_t separator = address.rfind(':');
+        if (separator == std::string::npos) {
+            Close();
+            return false;
+        }
+        std::string host = address.substr(0, separator);
+        if (host.length() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.length() - 2);
+        const std::string port = address.substr(separator + 1);
+
+        addrinfo hints = {};
+        hints.ai_family     = AF_UNSPEC;
+        hints.ai_socktype   = (type == LoggerSocketType::UDP) ? SOCK_DGRAM : SOCK_STREAM;
+
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+            Close();
+            return false;
+        }
+        memcpy(&m_address, result->ai_addr, result->ai_addrlen);
+        m_address_length = int(result->ai_addrlen);
+        freeaddrinfo(result);
+    }
+
+    char host_name[256] = {};
+    const bool is_host_name = gethostname(host_name, int(sizeof(host_name) - 1)) == 0 && host_name[0] != '\0';
+    m_syslog_header = std::string(is_host_name ? host_name : "-") + " " + (app_name.empty() ? "-" : app_name) + " " + std::to_string(GetCurrentProcessId()) + " - - ";
+
+    if (type == LoggerSocketType::UDP) {
+        // Connected datagram socket has default destination, so it's sent with 'send'.
+        m_socket = socket(m_address.ss_family, SOCK_DGRAM, 0);
+        u_long is_non_blocking = 1;
+        if (m_socket == INVALID_SOCKET || ioctlsocket(m_socket, FIONBIO, &is_non_blocking) != 0 || 
+                connect(m_socket, reinterpret_cast<const sockaddr*>(&m_address), m_address_length) != 0) {
+            Close();
+            return false;
+        }
+    }
+
+    m_next_connect_time = std::chrono::steady_clock::now();
+    m_sent_count        = 0;
+    m_dropped_count     = 0;
+    m_is_opened         = true;
+
+    m_thread = std::thread(&LoggerSocketSink::Send, this);
+    return true;
+}
+
+LOGGER_INLINE void LoggerSocketSink::Close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_close_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CLOSE_TIMEOUT_MS);
+            m_is_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    if (m_socket != INVALID_SOCKET) {
+        closesocket(m_socket);
+        m_socket = INVALID_SOCKET;
+    }
+    if (m_is_wsa_started) {
+        WSACleanup();
+        m_is_wsa_started = false;
+    }
+
+    m_buffer.clear();
+    m_buffer_ends.clear();
+    m_is_flush_requested    = false;
+    m_is_stop               = false;
+    m_is_opened             = false;
+}
+
+LOGGER_INLINE bool LoggerSocketSink::IsOpened() const {
+    return m_is_opened;
+}
+
+LOGGER_INLINE bool LoggerSocketSink::Push(const char* text, size_t length, int severity) {
+    char header[512];
+    int header_length = 0;
+
+    if (m_framing == LoggerSocketFraming::SYSLOG) {
+        if (length > 0 && text[length - 1] == '\n') --length;
+
+        const auto now = std::chrono::system_clock::now();
+        const time_t now_time = std::chrono::system_clock::to_time_t(now);
+        const long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+        tm ti = {};
+        gmtime_s(&ti, &now_time);
+
+        char message_header[384];
+        const int message_header_length = snprintf(message_header, sizeof(message_header), "<%d>1 %d-%02d-%02dT%02d:%02d:%02d.%06lldZ %s",
+            8 + ToSyslogSeverity(severity), 1900 + ti.tm_year, 1 + ti.tm_mon, ti.tm_mday, ti.tm_hour, ti.tm_min, ti.tm_sec, 
+            microseconds, m_syslog_header.c_str());
+        if (message_header_length < 0 || size_t(message_header_length) >= sizeof(message_header)) {
+            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (m_type == LoggerSocketType::UDP) {
+            memcpy(header, message_header, message_header_length);
+            header_length = message_header_length;
+        } else {
+            header_length = snprintf(header, sizeof(header), "%llu %s", (unsigned long long)(message_header_length + length), message_header);
+        }
+    } else {
+        const uint32_t text_length = uint32_t(length);
+        for (int index = 0; index < 4; ++index) header[index] = char((text_length >> (index * 8)) & 0xFF);
+        header_length = 4;
+    }
+
+    const size_t entry_length = header_length + length;
+    if (m_type == LoggerSocketType::UDP && entry_length > MAX_DATAGRAM_SIZE) {
+        m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    bool is_notify = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_buffer.length() + entry_length > m_buffer_size) {
+            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_buffer.append(header, header_length);
+        m_buffer.append(text, length);
+        m_buffer_ends.push_back(m_buffer.length());
+
+        is_notify = m_buffer.length() >= m_buffer_size / 2;
+    }
+    if (is_notify) m_condition.notify_one();
+
+    return true;
+}
+
+LOGGER_INLINE void LoggerSocketSink::Flush() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_flush_requested = true;
+    }
+    m_condition.notify_one();
+}
+
+LOGGER_INLINE uint64_t LoggerSocketSink::GetSentCount() const {
+    return m_sent_count.load(std::memory_order_relaxed);
+}
+
+LOGGER_INLINE uint64_t LoggerSocketSink::GetDroppedCount() const {
+    return m_dropped_count.load(std::memory_order_relaxed);
+}
+
+LOGGER_INLINE int LoggerSocketSink::ToSyslogSeverity(int severity) {
+    if (severity >= LoggerCategory::FatalError::SEVERITY)   return 2; // Critical
+    if (severity >= LoggerCategory::Error::SEVERITY)        return 3; // Error
+    if (severity >= LoggerCategory::Warning::SEVERITY)      return 4; // Warning
+    if (severity >= LoggerCategory::Event::SEVERITY)        return 6; // Informational
+    return 7;                                                         // Debug
+}
+
+LOGGER_INLINE void LoggerSocketSink::Send() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_condition.wait_for(lock, std::chrono::milliseconds(SEND_INTERVAL_MS), [this]() { 
+            return m_is_stop || m_is_flush_requested || m_buffer.length() >= m_buffer_size / 2; 
+        });
+        m_is_flush_requested = false;
+
+        if (m_buffer_ends.empty()) {
+            if (m_is_stop) break;
+            continue;
+        }
+
+        lock.unlock();
+        const bool is_connected = Connect();
+        lock.lock();
+
+        if (!is_connected) {
+            if (m_is_stop) {
+                m_dropped_count.fetch_add(m_buffer_ends.size(), std::memory_order_relaxed);
+                m_buffer.clear();
+                m_buffer_ends.clear();
+                break;
+            }
+            // Entries wait in buffer (or are dropped when it's full) until next connection attempt.
+            m_condition.wait_until(lock, m_next_connect_time, [this]() { return m_is_stop.load(); });
+            continue;
+        }
+
+        m_batch.swap(m_buffer);
+        m_batch_ends.swap(m_buffer_ends);
+
+        lock.unlock();
+        SendBatch();
+        m_batch.clear();
+        m_batch_ends.clear();
+        lock.lock();
+    }
+}
+
+LOGGER_INLINE bool LoggerSocketSink::Connect() {
+    if (m_socket != INVALID_SOCKET) return true;
+    if (!m_is_stop && std::chrono::steady_clock::now() < m_next_connect_time) return false;
+
+    m_next_connect_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(RECONNECT_INTERVAL_MS);
+
+    SOCKET socket_handle = socket(m_address.ss_family, SOCK_STREAM, 0);
+    if (socket_handle == INVALID_SOCKET) return false;
+
+    u_long is_non_blocking = 1;
+    bool is_success = ioctlsocket(socket_handle, FIONBIO, &is_non_blocking) == 0;
+
+    if (is_success && connect(socket_handle, reinterpret_cast<const sockaddr*>(&m_address), m_address_length) != 0) {
+        is_success = WSAGetLastError() == WSAEWOULDBLOCK && WaitForWritable(socket_handle, CONNECT_TIMEOUT_MS);
+        if (is_success) {
+            int error = 0;
+            socklen_t error_length = sizeof(error);
+            is_success = getsockopt(socket_handle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &error_length) == 0 && error == 0;
+        }
+    }
+
+    if (!is_success) {
+        closesocket(socket_handle);
+        return false;
+    }
+
+    m_socket = socket_handle;
+    return true;
+}
+
+LOGGER_INLINE void LoggerSocketSink::SendBatch() {
+    size_t begin        = 0;
+    size_t entry_index  = 0;
+
+    while (entry_index < m_batch_ends.size()) {
+        // Datagram contains one syslog message or as many length-prefixed entries as fit in it. 
+        // Stream gets whole batch at once.
+        size_t end_index = entry_index + 1;
+        if (m_type != LoggerSocketType::UDP) {
+            end_index = m_batch_ends.size();
+        } else if (m_framing == LoggerSocketFraming::LENGTH_PREFIXED) {
+            while (end_index < m_batch_ends.size() && m_batch_ends[end_index] - begin <= MAX_DATAGRAM_SIZE) ++end_index;
+        }
+        const size_t end = m_batch_ends[end_index - 1];
+
+        size_t sent_length = 0;
+        const bool is_success = SendAll(m_batch.c_str() + begin, end - begin, sent_length);
+
+        // Entries sent completely are counted as sent, the rest of batch is dropped.
+        size_t sent_count = 0;
+        while (entry_index + sent_count < end_index && m_batch_ends[entry_index + sent_count] <= begin + sent_length) ++sent_count;
+        m_sent_count.fetch_add(sent_count, std::memory_order_relaxed);
+
+        if (!is_success) {
+            if (m_type == LoggerSocketType::UDP) {
+                m_dropped_count.fetch_add(end_index - entry_index - sent_count, std::memory_order_relaxed);
+            } else {
+                m_dropped_count.fetch_add(m_batch_ends.size() - entry_index - sent_count, std::memory_order_relaxed);
+
+                // Partially sent entry breaks framing of stream, so connection is started again.
+                closesocket(m_socket);
+                m_socket = INVALID_SOCKET;
+                return;
+            }
+        }
+
+        begin       = end;
+        entry_index = end_index;
+    }
+}
+
+LOGGER_INLINE bool LoggerSocketSink::SendAll(const char* data, size_t length, size_t& sent_length) {
+    sent_length = 0;
+
+    while (sent_length < length) {
+        const size_t rest_length = length - sent_length;
+        const int count = send(m_socket, data + sent_length, int((rest_length < 0x40000000) ? rest_length : 0x40000000), 0);
+
+        if (count > 0) {
+            sent_length += count;
+            // Datagram is sent as whole or not at all.
+            if (m_type == LoggerSocketType::UDP) sent_length = length;
+        } else if (WSAGetLastError() == WSAEWOULDBLOCK) {
+            // Collector is slow, logging threads keep filling buffer in the meantime.
+            while (!WaitForWritable(m_socket, WAIT_INTERVAL_MS)) {
+                if (IsCloseTimeoutReached()) return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+LOGGER_INLINE bool LoggerSocketSink::WaitForWritable(SOCKET socket_handle, unsigned timeout_ms) {
+    fd_set write_set;
+    FD_ZERO(&write_set);
+    FD_SET(socket_handle, &write_set);
+
+    timeval timeout = {};
+    timeout.tv_sec  = long(timeout_ms / 1000);
+    timeout.tv_usec = long((timeout_ms % 1000) * 1000);
+
+    // First parameter is ignored on Windows.
+    return select(int(socket_handle + 1), nullptr, &write_set, nullptr, &timeout) > 0;
+}
+
+LOGGER_INLINE bool LoggerSocketSink::IsCloseTimeoutReached() const {
+    // Deadline is set before m_is_stop.
+    return m_is_stop && std::chrono::steady_clock::now() >= m_close_deadline;
+}
+
+#endif // LOGGER_USE_SOCKET
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerConsoleSink::LoggerConsoleSink() {
+    m_is_opened             = false;
+    m_is_colored            = false;
+    m_buffer_size           = 0;
+    m_is_flush_requested    = false;
+    m_is_stop               = false;
+    m_written_count         = 0;
+    m_dropped_count         = 0;
+}
+
+LOGGER_INLINE LoggerConsoleSink::~LoggerConsoleSink() {
+    Close();
+}
+
+LOGGER_INLINE void LoggerConsoleSink::Open(size_t buffer_size, bool is_colored) {
+    Close();
+
+    if (is_colored) {
+        // Console of Windows interprets ANSI escape sequences only in virtual terminal mode. Pipe passes them as they are.
+        HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (handle != INVALID_HANDLE_VALUE && GetConsoleMode(handle, &mode)) {
+            SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }
+    }
+
+    m_buffer_size   = buffer_size;
+    m_is_colored    = is_colored;
+    m_buffer.reserve(buffer_size);
+    m_is_opened     = true;
+
+    m_thread = std::thread(&LoggerConsoleSink::Write, this);
+}
+
+LOGGER_INLINE void LoggerConsoleSink::Close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_buffer_ends.clear();
+    m_is_flush_requested    = false;
+    m_is_stop               = false;
+    m_is_opened             = false;
+}
+
+LOGGER_INLINE bool LoggerConsoleSink::IsOpened() const {
+    return m_is_opened;
+}
+
+LOGGER_INLINE bool LoggerConsoleSink::Push(const char* text, size_t length, int severity) {
+    bool is_notify = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_buffer.length() + length > m_buffer_size) {
+            m_dropped_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_buffer.append(text, length);
+        m_buffer_ends.push_back({m_buffer.length(), severity});
+
+        is_notify = m_buffer.length() >= m_buffer_size / 2;
+    }
+    if (is_notify) m_condition.notify_one();
+
+    return true;
+}
+
+LOGGER_INLINE void LoggerConsoleSink::Flush() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_flush_requested = true;
+    }
+    m_condition.notify_one();
+}
+
+LOGGER_INLINE uint64_t LoggerConsoleSink::GetWrittenCount() const {
+    return m_written_count.load(std::memory_order_relaxed);
+}
+
+LOGGER_INLINE uint64_t LoggerConsoleSink::GetDroppedCount() const {
+    return m_dropped_count.load(std::memory_order_relaxed);
+}
+
+LOGGER_INLINE const char* LoggerConsoleSink::GetColor(int severity) {
+    if (severity >= LoggerCategory::FatalError::SEVERITY)   return "\x1B[1;31m";   // bold red
+    if (severity >= LoggerCategory::Error::SEVERITY)        return "\x1B[31m";     // red
+    if (severity >= LoggerCategory::Warning::SEVERITY)      return "\x1B[33m";     // yellow
+    if (severity >= LoggerCategory::Event::SEVERITY)        return "";
+    return "\x1B[90m";                                                              // gray
+}
+
+LOGGER_INLINE void LoggerConsoleSink::Write() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        m_condition.wait_for(lock, std::chrono::milliseconds(WRITE_INTERVAL_MS), [this]() { 
+            return m_is_stop || m_is_flush_requested || m_buffer.length() >= m_buffer_size / 2; 
+        });
+        m_is_flush_requested = false;
+
+        if (m_buffer_ends.empty()) {
+            if (m_is_stop) break;
+            continue;
+        }
+
+        // Entries logged while batch is written are collected in other buffer.
+        m_batch.swap(m_buffer);
+        m_batch_ends.swap(m_buffer_ends);
+        m_buffer.reserve(m_buffer_size);
+
+        lock.unlock();
+        WriteBatch();
+        m_batch.clear();
+        m_batch_ends.clear();
+        lock.lock();
+    }
+}
+
+LOGGER_INLINE void LoggerConsoleSink::WriteBatch() {
+    const std::string* batch = &m_batch;
+
+    if (m_is_colored) {
+        static const char RESET[] = "\x1B[0m";
+
+        m_colored_batch.clear();
+        size_t begin = 0;
+        for (const EntryEnd& entry_end : m_batch_ends) {
+            const char* color = GetColor(entry_end.severity);
+            if (*color) {
+                // Color is reset before end of line, so it doesn't leak to next line of other program.
+                const size_t end = (entry_end.end > begin && m_batch[entry_end.end - 1] == '\n') ? entry_end.end - 1 : entry_end.end;
+                m_colored_batch += color;
+                m_colored_batch.append(m_batch, begin, end - begin);
+                m_colored_batch += RESET;
+                m_colored_batch.append(m_batch, end, entry_end.end - end);
+            } else {
+                m_colored_batch.append(m_batch, begin, entry_end.end - begin);
+            }
+            begin = entry_end.end;
+        }
+        batch = &m_colored_batch;
+    }
+
+    if (fwide(stdout, 0) > 0) {
+        std::wstring batch_utf16(batch->length(), L'\0');
+        const int size = MultiByteToWideChar(CP_UTF8, 0, batch->c_str(), int(batch->length()), &batch_utf16[0], int(batch_utf16.length()));
+        batch_utf16.resize(size > 0 ? size : 0);
+        fputws(batch_utf16.c_str(), stdout);
+    } else {
+        fwrite(batch->c_str(), sizeof(char), batch->length(), stdout);
+    }
+    fflush(stdout);
+
+    m_written_count.fetch_add(m_batch_ends.size(), std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerCollector::LoggerCollector() {
+    m_abandon_timeout_ms    = 1000;
+    m_logger                = nullptr;
+    m_is_stop               = false;
+}
+
+LOGGER_INLINE LoggerCollector::~LoggerCollector() {
+    Destroy();
+}
+
+LOGGER_INLINE bool LoggerCollector::Create(const std::string& name, size_t slot_count, size_t slot_size) {
+    Destroy();
+
+    return m_ring.Create(name, slot_count, slot_size);
+}
+
+LOGGER_INLINE void LoggerCollector::Destroy() {
+    Stop();
+    m_ring.Close();
+}
+
+LOGGER_INLINE void LoggerCollector::SetAbandonTimeout(unsigned abandon_timeout_ms) {
+    m_abandon_timeout_ms = abandon_timeout_ms;
+}
+
+LOGGER_INLINE size_t LoggerCollector::Collect(Logger& logger) {
+    size_t count = 0;
+
+    if (m_ring.IsOpened()) {
+        while (m_ring.Pop(m_text, m_abandon_timeout_ms)) {
+            logger.LogText(m_text);
+            ++count;
+        }
+        if (count > 0) logger.Flush();
+    }
+
+    return count;
+}
+
+LOGGER_INLINE void LoggerCollector::Start(Logger& logger, unsigned interval_ms) {
+    Stop();
+
+    m_logger    = &logger;
+    m_is_stop   = false;
+    m_thread    = std::thread([this, interval_ms]() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_is_stop) {
+            lock.unlock();
+            Collect(*m_logger);
+            lock.lock();
+
+            m_condition.wait_for(lock, std::chrono::milliseconds(interval_ms), [this]() { return m_is_stop; });
+        }
+    });
+}
+
+LOGGER_INLINE void LoggerCollector::Stop() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_is_stop = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+
+        Collect(*m_logger);
+        m_logger = nullptr;
+    }
+}
+
+LOGGER_INLINE uint64_t LoggerCollector::GetDroppedCount() const {
+    return m_ring.GetDroppedCount();
+}
+
+LOGGER_INLINE uint64_t LoggerCollector::GetAbandonedCount() const {
+    return m_ring.GetAbandonedCount();
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerCompressedFileReader::LoggerCompressedFileReader() {
+    m_file = nullptr;
+}
+
+LOGGER_INLINE LoggerCompressedFileReader::~LoggerCompressedFileReader() {
+    Close();
+}
+
+LOGGER_INLINE bool LoggerCompressedFileReader::Open(const std::string& file_name) {
+    Close();
+
+    m_file = Logger::OpenFileUTF8(file_name, L"rb");
+    if (!m_file) return false;
+
+    uint64_t text_offset = 0;
+
+    while (true) {
+        unsigned char data[LoggerBlockCodec::HEADER_SIZE];
+        const size_t count = fread(data, 1, sizeof(data), m_file);
+
+        Block block;
+        if (count < sizeof(data) || !LoggerBlockCodec::DecodeHeader(data, block.header)) {
+            // Incomplete header is accepted only after valid blocks or if it looks like beginning of block.
+            const bool is_incomplete_block = count < sizeof(data) && memcmp(data, "LGBK", count < 4 ? count : 4) == 0;
+            if (m_blocks.empty() && !is_incomplete_block) {
+                Close();
+                return false;
+            }
+            break;
+        }
+
+        block.file_offset = _ftelli64(m_file);
+        block.text_offset = text_offset;
+
+        // Skips payload. Incomplete payload means block wasn't fully written.
+        if (_fseeki64(m_file, 0, SEEK_END) != 0) break;
+        if (_ftelli64(m_file) < block.file_offset + block.header.payload_size) break;
+        if (_fseeki64(m_file, block.file_offset + block.header.payload_size, SEEK_SET) != 0) break;
+
+        m_blocks.push_back(block);
+        text_offset += block.header.text_size;
+    }
+
+    return true;
+}
+
+LOGGER_INLINE void LoggerCompressedFileReader::Close() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_blocks.clear();
+}
+
+LOGGER_INLINE bool LoggerCompressedFileReader::IsOpened() const {
+    return m_file != nullptr;
+}
+
+LOGGER_INLINE size_t LoggerCompressedFileReader::GetBlockCount() const {
+    return m_blocks.size();
+}
+
+LOGGER_INLINE uint64_t LoggerCompressedFileReader::GetBlockTextOffset(size_t index) const {
+    return (index < m_blocks.size()) ? m_blocks[index].text_offset : 0;
+}
+
+LOGGER_INLINE bool LoggerCompressedFileReader::ReadBlock(size_t index, std::string& text) {
+    text.clear();
+    if (!m_file || index >= m_blocks.size()) return false;
+
+    const Block& block = m_blocks[index];
+
+    std::string payload(block.header.payload_size, '\0');
+    if (_fseeki64(m_file, block.file_offset, SEEK_SET) != 0) return false;
+    if (!payload.empty() && fread(&payload[0], 1, payload.length(), m_file) != payload.length()) return false;
+
+    return LoggerBlockCodec::DecodePayload(block.header, payload.c_str(), text);
+}
+
+LOGGER_INLINE bool LoggerCompressedFileReader::ReadAll(std::string& text) {
+    text.clear();
+    if (!m_file) return false;
+
+    std::string block_text;
+    for (size_t index = 0; index < m_blocks.size(); ++index) {
+        if (!ReadBlock(index, block_text)) return false;
+        text += block_text;
+    }
+    return true;
+}
+
+LOGGER_INLINE bool LoggerCompressedFileReader::DecompressFile(const std::string& file_name, const std::string& output_file_name) {
+    LoggerCompressedFileReader reader;
+    if (!reader.Open(file_name)) return false;
+
+    FILE* output = Logger::OpenFileUTF8(output_file_name, L"wb");
+    if (!output) return false;
+
+    bool is_success = true;
+    std::string text;
+    for (size_t index = 0; is_success && index < reader.GetBlockCount(); ++index) {
+        is_success = reader.ReadBlock(index, text) && fwrite(text.c_str(), 1, text.length(), output) == text.length();
+    }
+
+    fclose(output);
+    return is_success;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE std::string LoggerFileIndex::GetIndexFileName(const std::string& file_name) {
+    return file_name + ".idx";
+}
+
+LOGGER_INLINE void LoggerFileIndex::EncodeHeader(unsigned char* data) {
+    memcpy(data, "LGIX", 4);
+    WriteUInt32(data + 4, VERSION);
+    WriteUInt32(data + 8, RECORD_SIZE);
+    WriteUInt32(data + 12, 0);
+}
+
+LOGGER_INLINE bool LoggerFileIndex::DecodeHeader(const unsigned char* data) {
+    return memcmp(data, "LGIX", 4) == 0 && ReadUInt32(data + 4) == VERSION && ReadUInt32(data + 8) == RECORD_SIZE;
+}
+
+LOGGER_INLINE void LoggerFileIndex::EncodeRecord(unsigned char* data, const LoggerIndexSpan& span) {
+    WriteUInt64(data,       span.offset);
+    WriteUInt64(data + 8,   uint64_t(span.begin_time_ns));
+    WriteUInt64(data + 16,  uint64_t(span.end_time_ns));
+    WriteUInt32(data + 24,  span.entry_count);
+    WriteUInt32(data + 28,  span.trace_count);
+    WriteUInt32(data + 32,  span.dump_count);
+    WriteUInt32(data + 36,  span.event_count);
+    WriteUInt32(data + 40,  span.warning_count);
+    WriteUInt32(data + 44,  span.error_count);
+    WriteUInt32(data + 48,  span.fatal_error_count);
+    WriteUInt32(data + 52,  0);
+}
+
+LOGGER_INLINE void LoggerFileIndex::DecodeRecord(const unsigned char* data, LoggerIndexSpan& span) {
+    span.offset             = ReadUInt64(data);
+    span.length             = 0;
+    span.begin_time_ns      = int64_t(ReadUInt64(data + 8));
+    span.end_time_ns        = int64_t(ReadUInt64(data + 16));
+    span.entry_count        = ReadUInt32(data + 24);
+    span.trace_count        = ReadUInt32(data + 28);
+    span.dump_count         = ReadUInt32(data + 32);
+    span.event_count        = ReadUInt32(data + 36);
+    span.warning_count      = ReadUInt32(data + 40);
+    span.error_count        = ReadUInt32(data + 44);
+    span.fatal_error_count  = ReadUInt32(data + 48);
+}
+
+LOGGER_INLINE void LoggerFileIndex::CountEntry(LoggerIndexSpan& span, int severity) {
+    ++span.entry_count;
+
+    if (severity >= LoggerCategory::FatalError::SEVERITY) {
+        ++span.fatal_error_count;
+    } else if (severity >= LoggerCategory::Error::SEVERITY) {
+        ++span.error_count;
+    } else if (severity >= LoggerCategory::Warning::SEVERITY) {
+        ++span.warning_count;
+    } else if (severity >= LoggerCategory::Event::SEVERITY) {
+        ++span.event_count;
+    } else if (severity >= LoggerCategory::Dump::SEVERITY) {
+        ++span.dump_count;
+    } else {
+        ++span.trace_count;
+    }
+}
+
+LOGGER_INLINE void LoggerFileIndex::WriteUInt32(unsigned char* data, uint32_t value) {
+    for (size_t index = 0; index < 4; ++index) data[index] = (unsigned char)(value >> (index * 8));
+}
+
+LOGGER_INLINE void LoggerFileIndex::WriteUInt64(unsigned char* data, uint64_t value) {
+    for (size_t index = 0; index < 8; ++index) data[index] = (unsigned char)(value >> (index * 8));
+}
+
+LOGGER_INLINE uint32_t LoggerFileIndex::ReadUInt32(const unsigned char* data) {
+    uint32_t value = 0;
+    for (size_t index = 0; index < 4; ++index) value |= uint32_t(data[index]) << (index * 8);
+    return value;
+}
+
+LOGGER_INLINE uint64_t LoggerFileIndex::ReadUInt64(const unsigned char* data) {
+    uint64_t value = 0;
+    for (size_t index = 0; index < 8; ++index) value |= uint64_t(data[index]) << (index * 8);
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+LOGGER_INLINE LoggerIndexedFileReader::LoggerIndexedFileReader() {
+    m_file = nullptr;
+}
+
+LOGGER_INLINE LoggerIndexedFileReader::~LoggerIndexedFileReader() {
+    Close();
+}
+
+LOGGER_INLINE bool LoggerIndexedFileReader::Open(const std::string& file_name) {
+    Close();
+
+    FILE* index_file = Logger::OpenFileUTF8(LoggerFileIndex::GetIndexFileName(file_name), L"rb");
+    if (!index_file) return false;
+
+    unsigned char header[LoggerFileIndex::HEADER_SIZE];
+    bool is_valid = fread(header, 1, sizeof(header), index_file) == sizeof(header) && LoggerFileIndex::DecodeHeader(header);
+
+    // Incomplete record at the end is ignored.
+    unsigned char record[LoggerFileIndex::RECORD_SIZE];
+    while (is_valid && fread(record, 1, sizeof(record), index_file) == sizeof(record)) {
+        m_spans.push_back(LoggerIndexSpan());
+        LoggerFileIndex::DecodeRecord(record, m_spans.back());
+    }
+    fclose(index_file);
+
+    m_file = is_valid ? Logger::OpenFileUTF8(file_name, L"rb") : nullptr;
+    if (!m_file || _fseeki64(m_file, 0, SEEK_END) != 0) {
+        Close();
+        return false;
+    }
+    const uint64_t file_size = uint64_t(_ftelli64(m_file));
+
+    for (size_t index = 0; index < m_spans.size(); ++index) {
+        const uint64_t end = (index + 1 < m_spans.size()) ? m_spans[index + 1].offset : file_size;
+        m_spans[index].length = (end > m_spans[index].offset) ? (end - m_spans[index].offset) : 0;
+    }
+
+    return true;
+}
+
+LOGGER_INLINE void LoggerIndexedFileReader::Close() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_spans.clear();
+}
+
+LOGGER_INLINE bool LoggerIndexedFileReader::IsOpened() const {
+    return m_file != nullptr;
+}
+
+LOGGER_INLINE size_t LoggerIndexedFileReader::GetSpanCount() const {
+    return m_spans.size();
+}
+
+LOGGER_INLINE const LoggerIndexSpan& LoggerIndexedFileReader::GetSpan(size_t index) const {
+    return m_spans[index];
+}
+
+LOGGER_INLINE bool LoggerIndexedFileReader::ReadTimeRange(std::chrono::system_clock::time_point begin_time, std::chrono::system_clock::time_point end_time, std::string& text) {
+    text.clear();
+    if (!m_file) return false;
+
+    const int64_t begin_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(begin_time.time_since_epoch()).count();
+    const int64_t end_time_ns   = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time.time_since_epoch()).count();
+
+    // Spans are ordered by time, so first span which ends in range and first span which begins after range are found by binary search.
+    const auto first = std::lower_bound(m_spans.begin(), m_spans.end(), begin_time_ns, [](const LoggerIndexSpan& span, int64_t time_ns) {
+        return span.end_time_ns < time_ns;
+    });
+    const auto last = std::lower_bound(first, m_spans.end(), end_time_ns, [](const LoggerIndexSpan& span, int64_t time_ns) {
+        return span.begin_time_ns < time_ns;
+    });
+    if (first == last) return true;
+
+    const uint64_t offset = first->offset;
+    const uint64_t length = (last - 1)->offset + (last - 1)->length - offset;
+
+    text.resize(size_t(length));
+    return _fseeki64(m_file, int64_t(offset), SEEK_SET) == 0 && fread(&text[0], 1, text.length(), m_file) == text.length();
+}
+
+LOGGER_INLINE bool LoggerIndexedFileReader::ExtractTimeRange(const std::string& file_name, std::chrono::system_clock::time_point begin_time, std::chrono::system_clock::time_point end_time, const std::string& output_file_name) {
+    LoggerIndexedFileReader reader;
+    std::string text;
+    if (!reader.Open(file_name) || !reader.ReadTimeRange(begin_time, end_time, text)) return false;
+
+    FILE* output = Logger::OpenFileUTF8(output_file_name, L"wb");
+    if (!output) return false;
+
+    const bool is_success = fwrite(text.c_str(), 1, text.length(), output) == text.length();
+    fclose(output);
+    return is_success;
+}
+
+#endif // LOGGER_IMPL_H_
@@ -0,0 +1,14 @@
+/**
+* @file Logger.cpp
+* @author underwatergrasshopper
+* @version 2.0.1
+* 
+* Source of Logger library in compiled mode. Built by target Logger of CMakeLists.txt, 
+* which defines LOGGER_COMPILED_LIB for this file and for users of library.
+*/
+
+#ifndef LOGGER_COMPILED_LIB
+    #error "Logger.cpp requires LOGGER_COMPILED_LIB, otherwise Logger.h is header-only."
+#endif
+
+#include <LoggerImpl.h>